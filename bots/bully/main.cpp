@@ -46,7 +46,7 @@ int main(int argc, char* argv[]) {
     if(map.num_fleets() == 0) {
       // Search one of my planets having the more ships on it
       planet_id source_planet = 0;
-      for_each(map.planets_begin(), map.planets_end(), [&map, &source_planet](const Planet& planet) {
+      for_each(map.planets_begin(), map.planets_end(), [&map, &source_planet](ConstPlanetView planet) {
         if(planet.current_owner() == map.myself()) {
           if(source_planet == 0) source_planet = planet.id();
           else {
@@ -58,7 +58,7 @@ int main(int argc, char* argv[]) {
 
       // Search one of enemy or neutral planets having the less ships on it
       planet_id destination_planet = 0;
-      for_each(map.planets_begin(), map.planets_end(), [&map, &destination_planet](const Planet& planet) {
+      for_each(map.planets_begin(), map.planets_end(), [&map, &destination_planet](ConstPlanetView planet) {
         if(planet.current_owner() != map.myself()) {
           if(destination_planet == 0) destination_planet = planet.id();
           else {
@@ -36,7 +36,7 @@
 using namespace std;
 using namespace team_planets;
 
-bool is_owned_by_a_team(const vector<player_id>& team, const Planet& planet) {
+bool is_owned_by_a_team(const vector<player_id>& team, const ConstPlanetView& planet) {
   auto it = find(team.begin(), team.end(), planet.current_owner());
   return it != end(team);
 }
@@ -59,7 +59,7 @@ int main(int argc, char* argv[]) {
     if(map.num_fleets() == 0) {
       // Search one of my planets having the more ships on it
       planet_id source_planet = 0;
-      for_each(map.planets_begin(), map.planets_end(), [&map, &source_planet](const Planet& planet) {
+      for_each(map.planets_begin(), map.planets_end(), [&map, &source_planet](ConstPlanetView planet) {
         if(planet.current_owner() == map.myself()) {
           if(source_planet == 0) source_planet = planet.id();
           else {
@@ -71,7 +71,7 @@ int main(int argc, char* argv[]) {
 
       // Search one of enemy or neutral planets having the less ships on it
       planet_id destination_planet = 0;
-      for_each(map.planets_begin(), map.planets_end(), [&map, &my_team, &destination_planet](const Planet& planet) {
+      for_each(map.planets_begin(), map.planets_end(), [&map, &my_team, &destination_planet](ConstPlanetView planet) {
         if(planet.current_owner() == neutral_player || !is_owned_by_a_team(my_team, planet)) {
           if(destination_planet == 0) destination_planet = planet.id();
           else {
@@ -50,7 +50,7 @@ int main(int argc, char* argv[]) {
     unsigned int my_ships = 0, my_production = 0;
     unsigned int enemy_ships = 0, enemy_production = 0;
     for_each(map.planets_begin(), map.planets_end(),
-             [&map, &my_ships, &my_production, &enemy_ships, &enemy_production](const Planet& planet) {
+             [&map, &my_ships, &my_production, &enemy_ships, &enemy_production](ConstPlanetView planet) {
       if(planet.current_owner() == map.myself()) {
         my_ships += planet.current_num_ships();
         my_production += planet.ship_increase();
@@ -75,7 +75,7 @@ int main(int argc, char* argv[]) {
     if(map.num_fleets() <= max_simultaneous_attacks) {
       // Search one of my planets having the more ships on it
       planet_id source_planet = 0;
-      for_each(map.planets_begin(), map.planets_end(), [&map, &source_planet](const Planet& planet) {
+      for_each(map.planets_begin(), map.planets_end(), [&map, &source_planet](ConstPlanetView planet) {
         if(planet.current_owner() == map.myself()) {
           if(source_planet == 0) source_planet = planet.id();
           else {
@@ -88,7 +88,7 @@ int main(int argc, char* argv[]) {
       // Search one of enemy or neutral planets having the less ships on it
       planet_id destination_planet = 0;
       for_each(map.planets_begin(), map.planets_end(),
-               [attack_the_enemy, &map, &destination_planet](const Planet& planet) {
+               [attack_the_enemy, &map, &destination_planet](ConstPlanetView planet) {
         if(planet.current_owner() != map.myself()) {
           if(!attack_the_enemy || planet.current_owner() != neutral_player) {
             if(destination_planet == 0) destination_planet = planet.id();
@@ -42,7 +42,7 @@ int main(int argc, char* argv[]) {
   while(true) {
     map.bot_begin_turn();
 
-    for_each(map.planets_begin(), map.planets_end(), [&map](const Planet& planet) {
+    for_each(map.planets_begin(), map.planets_end(), [&map](ConstPlanetView planet) {
       if(planet.current_owner() == map.myself()) {
         // For each of my planets
         if(planet.current_num_ships() > 10*planet.ship_increase()) {
@@ -51,11 +51,11 @@ int main(int argc, char* argv[]) {
           // Finding the best planet to attack
           planet_id best_destination = 0;
           for_each(map.planets_begin(), map.planets_end(),
-                   [&map, &planet, &best_destination](const Planet& dest_planet) {
+                   [&map, &planet, &best_destination](ConstPlanetView dest_planet) {
             if(dest_planet.current_owner() != map.myself()) {
               if(best_destination == 0) best_destination = dest_planet.id();
-              else if(planet.compute_travel_distance(dest_planet)
-                  < planet.compute_travel_distance(map.planet(best_destination))) {
+              else if(map.travel_distance(planet.id(), dest_planet.id())
+                  < map.travel_distance(planet.id(), best_destination)) {
                 best_destination = dest_planet.id();
               }
             }
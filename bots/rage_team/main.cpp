@@ -35,7 +35,7 @@
 using namespace std;
 using namespace team_planets;
 
-bool is_owned_by_a_team(const vector<player_id>& team, const Planet& planet) {
+bool is_owned_by_a_team(const vector<player_id>& team, const ConstPlanetView& planet) {
   auto it = find(team.begin(), team.end(), planet.current_owner());
   return it != end(team);
 }
@@ -54,7 +54,7 @@ int main(int argc, char* argv[]) {
     if(map.message() != 0 && map.message() != (uint32_t)map.myself())
       my_team.push_back((player_id)map.message());
 
-    for_each(map.planets_begin(), map.planets_end(), [&map, &my_team](const Planet& planet) {
+    for_each(map.planets_begin(), map.planets_end(), [&map, &my_team](ConstPlanetView planet) {
       if(planet.current_owner() == map.myself()) {
         // For each of my planets
         if(planet.current_num_ships() > 10*planet.ship_increase()) {
@@ -63,12 +63,12 @@ int main(int argc, char* argv[]) {
           // Finding the best planet to attack
           planet_id best_destination = 0;
           for_each(map.planets_begin(), map.planets_end(),
-                   [&map, &my_team, &planet, &best_destination](const Planet& dest_planet) {
+                   [&map, &my_team, &planet, &best_destination](ConstPlanetView dest_planet) {
             if(dest_planet.current_owner() == neutral_player
                 || !is_owned_by_a_team(my_team, dest_planet)) {
               if(best_destination == 0) best_destination = dest_planet.id();
-              else if(planet.compute_travel_distance(dest_planet)
-                  < planet.compute_travel_distance(map.planet(best_destination))) {
+              else if(map.travel_distance(planet.id(), dest_planet.id())
+                  < map.travel_distance(planet.id(), best_destination)) {
                 best_destination = dest_planet.id();
               }
             }
@@ -39,23 +39,51 @@ using namespace sage;
 
 int Bot::run() {
   while(true) {
-    begin_turn_();
-    perform_turn_();
-    end_turn_();
+    map_.bot_begin_turn();
+
+    if(map_.bot_reset_requested()) {
+      // The engine starts a new game with this process
+      LOG << "Reset requested after " << current_turn_ - 1 << " turns." << endl;
+      reset_();
+      map_.bot_end_turn();
+    } else {
+      begin_turn_();
+      perform_turn_();
+      map_.bot_end_turn();
+      end_turn_();
+    }
   }
 
   return EXIT_FAILURE;
 }
 
+void Bot::play_turn(const teamplanets_turn_input& input, teamplanets_turn_output& output) {
+  map_.bot_begin_turn(input);
+  begin_turn_();
+  perform_turn_();
+  map_.bot_end_turn(output);
+  end_turn_();
+}
+
+void Bot::reset() {
+  LOG << "Reset requested after " << current_turn_ - 1 << " turns." << endl;
+  map_.bot_reset();
+  reset_();
+}
+
 void Bot::init_() {
 }
 
 void Bot::perform_turn_() {
 }
 
-void Bot::begin_turn_() {
-  map_.bot_begin_turn();
+void Bot::reset_() {
+  initialized_ = false;
+  current_turn_ = 1;
+  team_ = Team();
+}
 
+void Bot::begin_turn_() {
   // Saving the starting time
   starting_time_ = chrono::high_resolution_clock::now();
 
@@ -70,7 +98,6 @@ void Bot::begin_turn_() {
 }
 
 void Bot::end_turn_() {
-  map_.bot_end_turn();
   ++current_turn_;
 
   // Computing the overall processing time
@@ -42,21 +42,35 @@ namespace sage {
   public:
     DISABLE_COPY(Bot)
 
-    Bot(): initialized_(false), current_turn_(1) {}
+    Bot(): initialized_(false), current_turn_(1) {
+      // The same bot process may play several games in a row
+      map_.set_requested_protocol_extensions(map_.requested_protocol_extensions() | team_planets::reset_extension);
+    }
     virtual ~Bot() {}
 
     // Planet ownership checks
     bool team_is_complete() const { return team_.is_complete(); }
-    bool is_owned_by_me(const team_planets::Planet& planet) const { return planet.current_owner() == map_.myself(); }
-    bool is_neutral(const team_planets::Planet& planet) const { return planet.current_owner() == neutral_player; }
-    bool is_owned_by_my_team(const team_planets::Planet& planet) const { return team_.is_owned_by_my_team(planet); }
-    bool is_owned_by_enemy_team(const team_planets::Planet& planet) const {
+    bool is_owned_by_me(const team_planets::ConstPlanetView& planet) const {
+      return planet.current_owner() == map_.myself();
+    }
+    bool is_neutral(const team_planets::ConstPlanetView& planet) const {
+      return planet.current_owner() == neutral_player;
+    }
+    bool is_owned_by_my_team(const team_planets::ConstPlanetView& planet) const {
+      return team_.is_owned_by_my_team(planet);
+    }
+    bool is_owned_by_enemy_team(const team_planets::ConstPlanetView& planet) const {
       return team_.is_owned_by_enemy_team(planet);
     }
+    bool is_in_my_team(team_planets::player_id player) const { return team_.is_in_my_team(player); }
 
     // Bot main loop
     int run();
 
+    // In-process bot (see plugin.hpp), a turn is an iteration of the main loop
+    void play_turn(const teamplanets_turn_input& input, teamplanets_turn_output& output);
+    void reset();
+
   protected:
     // Various general info
     unsigned int current_turn() const { return current_turn_; }
@@ -68,6 +82,7 @@ namespace sage {
     // Function to overload
     virtual void init_();
     virtual void perform_turn_();
+    virtual void reset_();
 
   private:
     void begin_turn_();
@@ -51,7 +51,7 @@ void Decision::perform_backline_frontline_classification_() {
   frontline_planets_.clear();
   backline_planets_.clear();
 
-  for_each(map_.planets_begin(), map_.planets_end(), [this](const Planet& planet) {
+  for_each(map_.planets_begin(), map_.planets_end(), [this](ConstPlanetView planet) {
     if(bot_.is_owned_by_me(planet)) {
       if(is_frontline_(planet.id())) frontline_planets_.push_back(planet.id());
       else backline_planets_.push_back(planet.id());
@@ -64,7 +64,7 @@ unsigned int Decision::num_ships_to_take_a_planet_(planet_id src, planet_id dst)
   if(bot().is_neutral(map().planet(dst)))
     return map().planet(dst).current_num_ships() + 1;
 
-  const unsigned int travel_dist = map().planet(dst).compute_travel_distance(map().planet(src));
+  const unsigned int travel_dist = map().travel_distance(src, dst);
   return map().planet(dst).current_num_ships() + travel_dist*map().planet(dst).ship_increase() + 1;
 }
 
@@ -72,7 +72,7 @@ bool Decision::is_frontline_(planet_id id) const {
   bool frontline = false;
 
   for(size_t i = 0; i < bot_.neighbors(id).size(); ++i) {
-    const Planet& planet = map_.planet(bot_.neighbors(id)[i]);
+    const ConstPlanetView planet = map_.planet(bot_.neighbors(id)[i]);
     if(bot_.is_neutral(planet) || bot_.is_owned_by_enemy_team(planet)) frontline = true;
   }
 
@@ -69,7 +69,7 @@ void EnemyDecision::compute_list_of_potential_sources_and_targets_() {
 
     // Analyzing each neighbor
     for(size_t i = 0; i < bot().neighbors(dst_id).size(); ++i) {
-      const Planet& src_planet = map().planet(bot().neighbors(dst_id)[i]);
+      const ConstPlanetView src_planet = map().planet(bot().neighbors(dst_id)[i]);
 
       // If the planet is owned by the enemy
       if(bot().is_owned_by_enemy_team(src_planet)) {
@@ -92,14 +92,14 @@ Decision::orders_list EnemyDecision::generate_backline_orders_() {
   orders_list orders;
 
   // Analyzing all the enemy planets
-  for_each(map().planets_begin(), map().planets_end(), [this, &orders](const Planet& planet) {
+  for_each(map().planets_begin(), map().planets_end(), [this, &orders](ConstPlanetView planet) {
     if(bot().is_owned_by_enemy_team(planet)) {
       bool is_backline = true;
       vector<planet_id> neutral_neighbors;
       vector<planet_id> enemy_neighbors;
 
       for(size_t i = 0; is_backline && i < bot().neighbors(planet.id()).size(); ++i) {
-        const Planet& dst_planet = map().planet(bot().neighbors(planet.id())[i]);
+        const ConstPlanetView dst_planet = map().planet(bot().neighbors(planet.id())[i]);
         if(bot().is_owned_by_me(dst_planet)) is_backline = false;
         if(bot().is_neutral(dst_planet)) neutral_neighbors.push_back(dst_planet.id());
         if(bot().is_owned_by_my_team(dst_planet)) enemy_neighbors.push_back(dst_planet.id());
@@ -109,8 +109,8 @@ Decision::orders_list EnemyDecision::generate_backline_orders_() {
         // If the planet is backline, trying to attack the nearest enemy possible
         sort(enemy_neighbors.begin(), enemy_neighbors.end(),
              [this, &planet](const planet_id id1, const planet_id id2) {
-          const unsigned int dist1 = planet.compute_travel_distance(map().planet(id1));
-          const unsigned int dist2 = planet.compute_travel_distance(map().planet(id2));
+          const unsigned int dist1 = map().travel_distance(planet.id(), id1);
+          const unsigned int dist2 = map().travel_distance(planet.id(), id2);
           return dist1 < dist2;
         });
 
@@ -129,8 +129,8 @@ Decision::orders_list EnemyDecision::generate_backline_orders_() {
           // If not, try to attack the nearest neutral
           sort(neutral_neighbors.begin(), neutral_neighbors.end(),
                [this, &planet](const planet_id id1, const planet_id id2) {
-            const unsigned int dist1 = planet.compute_travel_distance(map().planet(id1));
-            const unsigned int dist2 = planet.compute_travel_distance(map().planet(id2));
+            const unsigned int dist1 = map().travel_distance(planet.id(), id1);
+            const unsigned int dist2 = map().travel_distance(planet.id(), id2);
             return dist1 < dist2;
           });
 
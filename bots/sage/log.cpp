@@ -41,10 +41,9 @@ Log::~Log() {
 }
 
 Log& Log::Instance() {
-  static Log* log = nullptr;
-  if(!log) log = new Log();
-
-  return *log;
+  // The in-process bots of each battle thread have their own log, destroyed with the thread
+  static thread_local Log log;
+  return log;
 }
 
 void Log::init_log(player_id id) {
@@ -68,13 +68,13 @@ Decision::orders_list MyDecision::generate_allies_orders() const {
   vector<planet_id> allied_useless;
 
   for_each(map().planets_begin(), map().planets_end(),
-           [this, &orders, &allied_frontline, &allied_useless](const Planet& planet) {
+           [this, &orders, &allied_frontline, &allied_useless](ConstPlanetView planet) {
     if(bot().is_owned_by_my_team(planet) && !bot().is_owned_by_me(planet)) {
       vector<planet_id> neutral_neighbors;
       vector<planet_id> enemy_neighbors;
 
       for(size_t i = 0; i < bot().neighbors(planet.id()).size(); ++i) {
-        const Planet& dst_planet = map().planet(bot().neighbors(planet.id())[i]);
+        const ConstPlanetView dst_planet = map().planet(bot().neighbors(planet.id())[i]);
         if(bot().is_neutral(dst_planet)) neutral_neighbors.push_back(dst_planet.id());
         if(bot().is_owned_by_enemy_team(dst_planet)) enemy_neighbors.push_back(dst_planet.id());
       }
@@ -85,8 +85,8 @@ Decision::orders_list MyDecision::generate_allies_orders() const {
       // Trying to attack the nearest enemy possible
       sort(enemy_neighbors.begin(), enemy_neighbors.end(),
            [this, &planet](const planet_id id1, const planet_id id2) {
-        const unsigned int dist1 = planet.compute_travel_distance(map().planet(id1));
-        const unsigned int dist2 = planet.compute_travel_distance(map().planet(id2));
+        const unsigned int dist1 = map().travel_distance(planet.id(), id1);
+        const unsigned int dist2 = map().travel_distance(planet.id(), id2);
         return dist1 < dist2;
       });
 
@@ -105,8 +105,8 @@ Decision::orders_list MyDecision::generate_allies_orders() const {
         // If not, try to attack the nearest neutral
         sort(neutral_neighbors.begin(), neutral_neighbors.end(),
              [this, &planet](const planet_id id1, const planet_id id2) {
-          const unsigned int dist1 = planet.compute_travel_distance(map().planet(id1));
-          const unsigned int dist2 = planet.compute_travel_distance(map().planet(id2));
+          const unsigned int dist1 = map().travel_distance(planet.id(), id1);
+          const unsigned int dist2 = map().travel_distance(planet.id(), id2);
           return dist1 < dist2;
         });
 
@@ -161,7 +161,7 @@ void MyDecision::compute_list_of_potential_targets_() {
   for(planet_id src_id:frontline_planets()) {
     // Analyzing each neighbor
     for(size_t i = 0; i < bot().neighbors(src_id).size(); ++i) {
-      const Planet& dst_planet = map().planet(bot().neighbors(src_id)[i]);
+      const ConstPlanetView dst_planet = map().planet(bot().neighbors(src_id)[i]);
 
       // Checking its status
       bool is_potential_target = bot().is_neutral(dst_planet)
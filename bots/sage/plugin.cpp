@@ -0,0 +1,65 @@
+// plugin.cpp - In-process bot entry points
+// sage - A TeamPlanets bot written for MachineZone job application
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include <exception>
+#include "plugin.hpp"
+#include "sagebot.hpp"
+
+using namespace sage;
+
+void* teamplanets_bot_init() {
+  try {
+    return new SageBot;
+  } catch(const std::exception&) {
+    return nullptr;
+  }
+}
+
+int teamplanets_bot_turn(void* bot, const teamplanets_turn_input* input, teamplanets_turn_output* output) {
+  try {
+    static_cast<SageBot*>(bot)->play_turn(*input, *output);
+    return 0;
+  } catch(const std::exception&) {
+    return -1;
+  }
+}
+
+int teamplanets_bot_reset(void* bot) {
+  try {
+    static_cast<SageBot*>(bot)->reset();
+    return 0;
+  } catch(const std::exception&) {
+    return -1;
+  }
+}
+
+void teamplanets_bot_free(void* bot) {
+  delete static_cast<SageBot*>(bot);
+}
@@ -41,6 +41,24 @@ using namespace sage;
 
 void SageBot::init_() {
   LOG << "SageBot Version 1.0 was started for player " << map().myself() << endl;
+
+  // Nothing to compute if the previous game was played on the same map
+  vector<Coordinates> locations;
+  for_each(map().planets_begin(), map().planets_end(), [&locations](ConstPlanetView planet) {
+    locations.push_back(planet.location());
+  });
+
+  const bool same_map = locations.size() == neighborhoods_locations_.size()
+                        && equal(locations.begin(), locations.end(), neighborhoods_locations_.begin(),
+                                 [](const Coordinates& c1, const Coordinates& c2) {
+    return c1.x() == c2.x() && c1.y() == c2.y();
+  });
+  if(same_map) {
+    LOG << "Reusing the initial computations of the previous game." << endl << endl;
+    return;
+  }
+  neighborhoods_locations_ = locations;
+
   LOG << "Perform initial computations..." << endl;
 
   // Computing mean travel distance between the planets
@@ -116,11 +134,12 @@ void SageBot::perform_turn_() {
 unsigned int SageBot::compute_planets_mean_distance_() const {
   unsigned long long int dist_sum = 0;
 
-  for_each(map().planets_begin(), map().planets_end(), [this, &dist_sum](const Planet& planet) {
+  for_each(map().planets_begin(), map().planets_end(), [this, &dist_sum](ConstPlanetView planet) {
     unsigned int distance_to_nearest_planet = 1000;
-    for_each(map().planets_begin(), map().planets_end(), [&planet,&distance_to_nearest_planet](const Planet& planet2) {
+    for_each(map().planets_begin(), map().planets_end(),
+             [this, &planet, &distance_to_nearest_planet](ConstPlanetView planet2) {
       if(planet2.id() != planet.id()) {
-        const unsigned int dist = planet.compute_travel_distance(planet2);
+        const unsigned int dist = map().travel_distance(planet.id(), planet2.id());
         if(dist < distance_to_nearest_planet) distance_to_nearest_planet = dist;
       }
     });
@@ -139,7 +158,7 @@ void SageBot::compute_planets_neighborhoods_() {
   for(planet_id id = 1; id <= map().num_planets(); ++id) {
     for(planet_id id2 = 1; id2 <= map().num_planets(); ++id2) {
       if(id2 != id) {
-        if(map().planet(id).compute_travel_distance(map().planet(id2)) <= neighborhood_radius_)
+        if(map().travel_distance(id, id2) <= neighborhood_radius_)
           neighborhoods_[id - 1].push_back(id2);
       }
     }
@@ -155,12 +174,13 @@ void SageBot::generate_possibilities_tree_(Leaf_& root) {
 
   // Main loop
   start_time_ = chrono::high_resolution_clock::now();
+  const chrono::milliseconds max_duration = max_tree_gen_duration_();
   chrono::milliseconds cur_duration(0);
   max_tree_depth_ = 0;
-  while(!current_level.empty() && cur_duration < max_tree_comp_duration_) {
+  while(!current_level.empty() && cur_duration < max_duration) {
     next_level.clear();
 
-    for(size_t n = 0; n < current_level.size() && cur_duration < max_tree_comp_duration_; ++n) {
+    for(size_t n = 0; n < current_level.size() && cur_duration < max_duration; ++n) {
       Leaf_& current_leaf = *(current_level[n]);
 
       // Checking if the current leaf is not an end game position
@@ -252,15 +272,23 @@ void SageBot::update_child_leaves_maps(Leaf_& leaf) const {
 bool SageBot::is_game_over_(const Leaf_& leaf) const {
   if(leaf.current_turn >= max_turn_) return true;
 
-  unsigned int my_team_planets = 0;
-  unsigned int enemy_team_planets = 0;
-  for_each(leaf.map.planets_begin(), leaf.map.planets_end(),
-           [this, &my_team_planets, &enemy_team_planets](const Planet& planet) {
-    if(is_owned_by_my_team(planet)) ++my_team_planets;
-    if(is_owned_by_enemy_team(planet)) ++enemy_team_planets;
-  });
+  // The game goes on while both teams own a planet, only the owners array is scanned
+  bool my_team_alive = false, enemy_team_alive = false;
+  for(player_id owner:leaf.map.planets().owners()) {
+    if(owner == neutral_player) continue;
+    if(is_in_my_team(owner)) my_team_alive = true;
+    else enemy_team_alive = true;
+    if(my_team_alive && enemy_team_alive) return false;
+  }
 
-  return (my_team_planets == 0) || (enemy_team_planets == 0);
+  return true;
+}
+
+// Half of the turn time, plus a part of the time bank: the bank drains while the tree is large and refills
+// on the quick turns
+chrono::milliseconds SageBot::max_tree_gen_duration_() const {
+  if(map().turn_time() == 0) return max_tree_comp_duration_;
+  return chrono::milliseconds(map().turn_time()/2 + map().time_bank()/10);
 }
 
 chrono::milliseconds SageBot::current_tree_gen_duration_() const {
@@ -319,25 +347,22 @@ float SageBot::compute_final_state_score_(const Leaf_& leaf) const {
   const float planet_coeff = 0.1f;
   const float ship_coeff = 0.0001f;
 
-  // Evaluating the number of ships and planets for each team
+  // Evaluating the number of ships and planets for each team, over the owners and ships arrays
   unsigned int my_team_planets = 0, my_team_ships = 0;
   unsigned int enemy_team_planets = 0, enemy_team_ships = 0;
-  unsigned int neutral_planets = 0;
-
-  for_each(leaf.map.planets_begin(), leaf.map.planets_end(),
-           [this, &my_team_planets, &my_team_ships, &enemy_team_planets,
-            &enemy_team_ships, &neutral_planets](const Planet& planet) {
-    if(is_neutral(planet)) ++neutral_planets;
-    else {
-      if(is_owned_by_my_team(planet)) {
-        ++my_team_planets;
-        my_team_ships += planet.current_num_ships();
-      } else if(is_owned_by_enemy_team(planet)) {
-        ++enemy_team_planets;
-        enemy_team_ships += planet.current_num_ships();
-      }
+
+  const vector<player_id>&    owners = leaf.map.planets().owners();
+  const vector<unsigned int>& num_ships = leaf.map.planets().num_ships();
+  for(size_t i = 0; i < owners.size(); ++i) {
+    if(owners[i] == neutral_player) continue;
+    if(is_in_my_team(owners[i])) {
+      ++my_team_planets;
+      my_team_ships += num_ships[i];
+    } else {
+      ++enemy_team_planets;
+      enemy_team_ships += num_ships[i];
     }
-  });
+  }
 
   if(my_team_planets == 0) return -1000.0f;    // We are dead, very bad
   if(enemy_team_planets == 0) return 1000.0f;  // Enemy is dead, very good
@@ -82,6 +82,7 @@ namespace sage {
     void update_child_leaves_maps(Leaf_& leaf) const;
     bool is_game_over_(const Leaf_& leaf) const;
     std::chrono::milliseconds current_tree_gen_duration_() const;
+    std::chrono::milliseconds max_tree_gen_duration_() const;
 
     void compute_possibility_tree_scores_(Leaf_& root) const;
     float compute_final_state_score_(const Leaf_& leaf) const;
@@ -91,10 +92,11 @@ namespace sage {
     unsigned int  neighborhood_radius_multiplier_;
     unsigned int  neighborhood_radius_;
 
-    // Precomputed planets neighborhoods
-    neighborhoods_list  neighborhoods_;
+    // Precomputed planets neighborhoods, kept across the games played on the same map
+    neighborhoods_list                      neighborhoods_;
+    std::vector<team_planets::Coordinates>  neighborhoods_locations_;
 
-    // User defined possibilities tree parameters
+    // User defined possibilities tree parameters, the duration is used when the engine have no time control
     const std::chrono::milliseconds max_tree_comp_duration_;
     const unsigned int              max_turn_;
 
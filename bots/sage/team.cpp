@@ -41,15 +41,19 @@ Team::Team():
 }
 
 // Planet ownership tests
-bool Team::is_owned_by_my_team(const Planet& planet) const {
-  auto it = find(team_.begin(), team_.end(), planet.current_owner());
-  return it != end(team_);
+bool Team::is_owned_by_my_team(const ConstPlanetView& planet) const {
+  return is_in_my_team(planet.current_owner());
 }
 
-bool Team::is_owned_by_enemy_team(const Planet& planet) const {
+bool Team::is_owned_by_enemy_team(const ConstPlanetView& planet) const {
   return planet.current_owner() != neutral_player && !is_owned_by_my_team(planet);
 }
 
+bool Team::is_in_my_team(player_id player) const {
+  auto it = find(team_.begin(), team_.end(), player);
+  return it != end(team_);
+}
+
 uint32_t Team::process_message(player_id myself, uint32_t msg) {
   if(team_.empty()) team_.push_back(myself);
 
@@ -36,7 +36,7 @@
 #include <ostream>
 #include "basic_types.hpp"
 
-namespace team_planets { class Planet; }
+namespace team_planets { class ConstPlanetView; }
 
 namespace sage {
   class Team {
@@ -44,8 +44,9 @@ namespace sage {
     Team();
 
     // Planet ownership tests
-    bool is_owned_by_my_team(const team_planets::Planet& planet) const;
-    bool is_owned_by_enemy_team(const team_planets::Planet& planet) const;
+    bool is_owned_by_my_team(const team_planets::ConstPlanetView& planet) const;
+    bool is_owned_by_enemy_team(const team_planets::ConstPlanetView& planet) const;
+    bool is_in_my_team(team_planets::player_id player) const;
 
     // Team management
     bool is_complete() const { return team_is_complete_; }
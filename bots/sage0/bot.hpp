@@ -57,10 +57,16 @@ namespace sage {
 
     // Planet ownership checks
     bool team_is_complete_() const { return team_.is_complete(); }
-    bool is_owned_by_me_(const team_planets::Planet& planet) const { return planet.current_owner() == map_.myself(); }
-    bool is_neutral_(const team_planets::Planet& planet) const { return planet.current_owner() == neutral_player; }
-    bool is_owned_by_my_team_(const team_planets::Planet& planet) const { return team_.is_owned_by_my_team(planet); }
-    bool is_owned_by_enemy_team_(const team_planets::Planet& planet) const {
+    bool is_owned_by_me_(const team_planets::ConstPlanetView& planet) const {
+      return planet.current_owner() == map_.myself();
+    }
+    bool is_neutral_(const team_planets::ConstPlanetView& planet) const {
+      return planet.current_owner() == neutral_player;
+    }
+    bool is_owned_by_my_team_(const team_planets::ConstPlanetView& planet) const {
+      return team_.is_owned_by_my_team(planet);
+    }
+    bool is_owned_by_enemy_team_(const team_planets::ConstPlanetView& planet) const {
       return team_.is_owned_by_enemy_team(planet);
     }
 
@@ -74,7 +74,7 @@ void SageBot::perform_turn_() {
   // Classifying planets as front/back line
   frontline_planets_.clear();
   backline_planets_.clear();
-  for_each(map().planets_begin(), map().planets_end(), [this](const Planet& planet) {
+  for_each(map().planets_begin(), map().planets_end(), [this](ConstPlanetView planet) {
     if(is_owned_by_me_(planet)) {
       if(is_frontline_(planet.id())) frontline_planets_.push_back(planet.id());
       else backline_planets_.push_back(planet.id());
@@ -102,7 +102,7 @@ bool SageBot::is_frontline_(planet_id id) const {
   bool frontline = false;
 
   for(size_t i = 0; i < neighbors_(id).size(); ++i) {
-    const Planet& planet = map().planet(neighbors_(id)[i]);
+    const ConstPlanetView planet = map().planet(neighbors_(id)[i]);
     if(is_neutral_(planet) || is_owned_by_enemy_team_(planet)) frontline = true;
   }
 
@@ -114,7 +114,7 @@ unsigned int SageBot::num_ships_to_take_a_planet_(planet_id src, planet_id dst)
   if(is_neutral_(map().planet(dst)))
     return map().planet(dst).current_num_ships() + 1;
 
-  const unsigned int travel_dist = map().planet(dst).compute_travel_distance(map().planet(src));
+  const unsigned int travel_dist = map().travel_distance(src, dst);
   return map().planet(dst).current_num_ships() + travel_dist*map().planet(dst).ship_increase() + 1;
 }
 
@@ -129,7 +129,7 @@ void SageBot::take_attack_decisions_() {
   // Computing the list of potential targets
   for(planet_id id:frontline_planets_) {
     for(size_t i = 0; i < neighbors_(id).size(); ++i) {
-      const Planet& dst_planet = map().planet(neighbors_(id)[i]);
+      const ConstPlanetView dst_planet = map().planet(neighbors_(id)[i]);
 
       Target tgt;
       tgt.id = dst_planet.id();
@@ -202,7 +202,7 @@ void SageBot::process_backline_planet_(planet_id id) {
     planet_id     best_planet_to_reinforce    = 0;
     unsigned int  best_planet_travel_distance = 1000;
     for(planet_id dst_id:frontline_planets_) {
-      const unsigned int dist = map().planet(dst_id).compute_travel_distance(map().planet(id));
+      const unsigned int dist = map().travel_distance(id, dst_id);
       if(best_planet_to_reinforce == 0 || dist < best_planet_travel_distance) {
         best_planet_to_reinforce = dst_id;
         best_planet_travel_distance = dist;
@@ -222,11 +222,12 @@ void SageBot::process_backline_planet_(planet_id id) {
 unsigned int SageBot::compute_planets_mean_distance_() const {
   unsigned long long int dist_sum = 0;
 
-  for_each(map().planets_begin(), map().planets_end(), [this, &dist_sum](const Planet& planet) {
+  for_each(map().planets_begin(), map().planets_end(), [this, &dist_sum](ConstPlanetView planet) {
     unsigned int distance_to_nearest_planet = 1000;
-    for_each(map().planets_begin(), map().planets_end(), [&planet,&distance_to_nearest_planet](const Planet& planet2) {
+    for_each(map().planets_begin(), map().planets_end(),
+             [this, &planet, &distance_to_nearest_planet](ConstPlanetView planet2) {
       if(planet2.id() != planet.id()) {
-        const unsigned int dist = planet.compute_travel_distance(planet2);
+        const unsigned int dist = map().travel_distance(planet.id(), planet2.id());
         if(dist < distance_to_nearest_planet) distance_to_nearest_planet = dist;
       }
     });
@@ -245,7 +246,7 @@ void SageBot::compute_planets_neighborhoods_() {
   for(planet_id id = 1; id <= map().num_planets(); ++id) {
     for(planet_id id2 = 1; id2 <= map().num_planets(); ++id2) {
       if(id2 != id) {
-        if(map().planet(id).compute_travel_distance(map().planet(id2)) <= neighborhood_radius_)
+        if(map().travel_distance(id, id2) <= neighborhood_radius_)
           neighborhoods_[id - 1].push_back(id2);
       }
     }
@@ -41,12 +41,12 @@ Team::Team():
 }
 
 // Planet ownership tests
-bool Team::is_owned_by_my_team(const Planet& planet) const {
+bool Team::is_owned_by_my_team(const ConstPlanetView& planet) const {
   auto it = find(team_.begin(), team_.end(), planet.current_owner());
   return it != end(team_);
 }
 
-bool Team::is_owned_by_enemy_team(const Planet& planet) const {
+bool Team::is_owned_by_enemy_team(const ConstPlanetView& planet) const {
   return planet.current_owner() != neutral_player && !is_owned_by_my_team(planet);
 }
 
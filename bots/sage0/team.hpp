@@ -44,8 +44,8 @@ namespace sage {
     Team();
 
     // Planet ownership tests
-    bool is_owned_by_my_team(const team_planets::Planet& planet) const;
-    bool is_owned_by_enemy_team(const team_planets::Planet& planet) const;
+    bool is_owned_by_my_team(const team_planets::ConstPlanetView& planet) const;
+    bool is_owned_by_enemy_team(const team_planets::ConstPlanetView& planet) const;
 
     // Team management
     bool is_complete() const { return team_is_complete_; }
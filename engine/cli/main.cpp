@@ -0,0 +1,296 @@
+// main.cpp - Command line engine entry point
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include <QCoreApplication>
+#include <QString>
+#include <QTextStream>
+#include <QStringList>
+#include <QThread>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include "logger.hpp"
+#include "battlethread.hpp"
+#include "tournament.hpp"
+
+using namespace team_planets;
+using namespace team_planets_engine;
+
+static void print_usage(const char* app_name) {
+  QTextStream err(stderr);
+  err << "Usage: " << app_name << " <MAP> <TEAM_1_BOT> <TEAM_1_NUM_PLAYERS> "
+      << "<TEAM_2_BOT> <TEAM_2_NUM_PLAYERS> [--replay <REPLAY_FILE>] [--profile <PROFILE_FILE>] "
+      << "[--cpu-budget <MSECS>] [--turn-time <MSECS>] [--time-bank <MSECS>] [--adjudicate <RATIO> <TURNS>] "
+      << "[--concurrent]" << endl;
+  err << "       " << app_name << " --tournament <RESULTS_FILE> [--jobs <NUM_WORKERS>] "
+      << "[--replays <REPLAYS_DIR>] [--cpu-budget <MSECS>] [--turn-time <MSECS>] [--time-bank <MSECS>] "
+      << "[--adjudicate <RATIO> <TURNS>] [--concurrent] --maps <MAP>... --bots <BOT>..." << endl;
+  err << "Logging options: [--log-level debug|info|warning|error|off] [--log-file <LOG_FILE>]" << endl;
+}
+
+// The logging options are common to the battles and the tournaments, they are removed from the arguments
+static bool parse_log_options(int& argc, char* argv[]) {
+  int num_args = 1;
+  for(int i = 1; i < argc; ++i) {
+    const QString arg = argv[i];
+
+    if(arg == "--log-level" && i + 1 < argc) {
+      Logger::Level level;
+      if(!Logger::parse_level(argv[++i], level)) return false;
+      Logger::instance().set_level(level);
+    } else if(arg == "--log-file" && i + 1 < argc) {
+      try {
+        Logger::instance().set_file(argv[++i]);
+      } catch(const std::exception& e) {
+        QTextStream(stderr) << "ERROR: " << e.what() << endl;
+        return false;
+      }
+    } else argv[num_args++] = argv[i];
+  }
+
+  argc = num_args;
+  return true;
+}
+
+// The adjudication ratio must be above 1, and the number of turns positive
+static bool parse_adjudication(const char* ratio_arg, const char* turns_arg, float& ratio, unsigned int& num_turns) {
+  bool ratio_ok = false, turns_ok = false;
+  ratio = QString(ratio_arg).toFloat(&ratio_ok);
+  num_turns = QString(turns_arg).toUInt(&turns_ok);
+  return ratio_ok && turns_ok && ratio > 1.0f && num_turns != 0;
+}
+
+static void print_battle_summary(BattleThread& battle) {
+  QTextStream out(stdout);
+
+  out << "Map: " << battle.map_file_name() << endl;
+  out << "Turns: " << battle.current_turn() << endl;
+  if(battle.winner() != 0) out << "Winner: team " << battle.winner();
+  else out << "Winner: none";
+  out << (battle.adjudicated() ? " (adjudicated)" : "") << endl;
+
+  // Per player statistics
+  out << "ID\tTeam\tStatus\tPlanets\tShips\tPing (ms)\tp50\tp95\tp99\tMax\tCPU (ms)" << endl;
+  std::for_each(battle.players_begin(), battle.players_end(), [&out](const Player& player) {
+    QString status;
+    switch(player.status()) {
+    case Player::Alive: status = "alive"; break;
+    case Player::Dead: status = "dead"; break;
+    case Player::Failed: status = "failed"; break;
+    }
+
+    out << player.id() << '\t' << player.team() << '\t' << status << '\t' << player.num_planets() << '\t'
+        << player.num_ships() << '\t' << player.ping() << '\t' << player.ping_percentile(50) << '\t'
+        << player.ping_percentile(95) << '\t' << player.ping_percentile(99) << '\t' << player.max_ping() << '\t'
+        << player.total_cpu_time() << endl;
+  });
+
+  // Engine time per turn phase
+  const TurnProfiler& profiler = battle.profiler();
+  const double total_ms = std::chrono::duration<double, std::milli>(profiler.total_duration()).count();
+  out << "Phase\tTotal (ms)\tPer turn (ms)\tShare (%)" << endl;
+  for(int phase = 0; phase < TurnProfiler::NumPhases; ++phase) {
+    const double phase_ms =
+        std::chrono::duration<double, std::milli>(profiler.total_duration((TurnProfiler::Phase)phase)).count();
+    out << TurnProfiler::phase_name((TurnProfiler::Phase)phase) << '\t' << QString::number(phase_ms, 'f', 1) << '\t'
+        << QString::number(profiler.num_turns() != 0 ? phase_ms/profiler.num_turns() : 0.0, 'f', 3) << '\t'
+        << QString::number(total_ms != 0.0 ? 100.0*phase_ms/total_ms : 0.0, 'f', 1) << endl;
+  }
+}
+
+static int run_battle(QCoreApplication& app, int argc, char* argv[]) {
+  // Parsing the command line
+  if(argc < 6) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  QString       replay_file_name, profile_file_name;
+  unsigned int  cpu_budget = 0, turn_time = 1000, time_bank = 0;
+  float         adjudication_ratio = 0.0f;
+  unsigned int  adjudication_turns = 0;
+  bool          concurrent_bots = false;
+  for(int i = 6; i < argc; ++i) {
+    const QString arg = argv[i];
+    bool ok = true;
+
+    if(arg == "--replay" && i + 1 < argc) replay_file_name = argv[++i];
+    else if(arg == "--profile" && i + 1 < argc) profile_file_name = argv[++i];
+    else if(arg == "--cpu-budget" && i + 1 < argc) cpu_budget = QString(argv[++i]).toUInt(&ok);
+    else if(arg == "--turn-time" && i + 1 < argc) turn_time = QString(argv[++i]).toUInt(&ok);
+    else if(arg == "--time-bank" && i + 1 < argc) time_bank = QString(argv[++i]).toUInt(&ok);
+    else if(arg == "--adjudicate" && i + 2 < argc) {
+      ok = parse_adjudication(argv[i + 1], argv[i + 2], adjudication_ratio, adjudication_turns);
+      i += 2;
+    } else if(arg == "--concurrent") concurrent_bots = true;
+    else ok = false;
+
+    if(!ok || turn_time == 0) {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  bool ok1 = false, ok2 = false;
+  const unsigned int team1_num_players = QString(argv[3]).toUInt(&ok1);
+  const unsigned int team2_num_players = QString(argv[5]).toUInt(&ok2);
+  if(!ok1 || !ok2 || team1_num_players == 0 || team2_num_players == 0) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // Running the battle at full speed, the log goes to the standard error
+  BattleThread battle(argv[1], argv[2], team1_num_players, argv[4], team2_num_players);
+  battle.set_turn_delay(0);
+  battle.set_replay_file_name(replay_file_name);
+  battle.set_profile_file_name(profile_file_name);
+  battle.set_cpu_budget(cpu_budget);
+  battle.set_turn_time(turn_time);
+  battle.set_time_bank(time_bank);
+  battle.set_adjudication(adjudication_ratio, adjudication_turns);
+  battle.set_concurrent_bots(concurrent_bots);
+
+  bool error_occured = false;
+  QObject::connect(&battle, &BattleThread::error_occured, &app, [&error_occured](const QString&) {
+    error_occured = true;
+  });
+  QObject::connect(&battle, &QThread::finished, &app, &QCoreApplication::quit);
+
+  battle.start();
+  app.exec();
+  battle.wait();
+
+  // Writing the battle results to the standard output
+  print_battle_summary(battle);
+
+  return error_occured ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static int run_tournament(QCoreApplication& app, int argc, char* argv[]) {
+  // Parsing the command line
+  if(argc < 3) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const QString results_file_name = argv[2];
+  unsigned int  num_workers = (unsigned int)QThread::idealThreadCount();
+  QString       replays_directory;
+  unsigned int  cpu_budget = 0, turn_time = 1000, time_bank = 0;
+  float         adjudication_ratio = 0.0f;
+  unsigned int  adjudication_turns = 0;
+  bool          concurrent_bots = false;
+  QStringList   maps_file_names;
+  QStringList   bots_file_names;
+  QStringList*  current_list = nullptr;
+
+  for(int i = 3; i < argc; ++i) {
+    const QString arg = argv[i];
+
+    if(arg == "--jobs" && i + 1 < argc) {
+      bool ok = false;
+      num_workers = QString(argv[++i]).toUInt(&ok);
+      if(!ok || num_workers == 0) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+      }
+      current_list = nullptr;
+    } else if(arg == "--replays" && i + 1 < argc) {
+      replays_directory = argv[++i];
+      current_list = nullptr;
+    } else if((arg == "--cpu-budget" || arg == "--turn-time" || arg == "--time-bank") && i + 1 < argc) {
+      bool ok = false;
+      const unsigned int value = QString(argv[++i]).toUInt(&ok);
+      if(!ok || (arg == "--turn-time" && value == 0)) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+      }
+
+      if(arg == "--cpu-budget") cpu_budget = value;
+      else if(arg == "--turn-time") turn_time = value;
+      else time_bank = value;
+      current_list = nullptr;
+    } else if(arg == "--adjudicate" && i + 2 < argc) {
+      if(!parse_adjudication(argv[i + 1], argv[i + 2], adjudication_ratio, adjudication_turns)) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+      }
+      i += 2;
+      current_list = nullptr;
+    } else if(arg == "--concurrent") {
+      concurrent_bots = true;
+      current_list = nullptr;
+    } else if(arg == "--maps") current_list = &maps_file_names;
+    else if(arg == "--bots") current_list = &bots_file_names;
+    else if(current_list) current_list->append(arg);
+    else {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if(maps_file_names.isEmpty() || bots_file_names.isEmpty()) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // Playing all the matches
+  Tournament tournament(maps_file_names, bots_file_names, results_file_name, num_workers);
+  tournament.set_replays_directory(replays_directory);
+  tournament.set_cpu_budget(cpu_budget);
+  tournament.set_time_control(turn_time, time_bank);
+  tournament.set_adjudication(adjudication_ratio, adjudication_turns);
+  tournament.set_concurrent_bots(concurrent_bots);
+  QObject::connect(&tournament, &Tournament::finished, &app, &QCoreApplication::quit, Qt::QueuedConnection);
+
+  try {
+    tournament.start();
+  } catch(const std::exception& e) {
+    QTextStream(stderr) << "ERROR: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+  app.exec();
+
+  QTextStream(stdout) << "Tournament is over: " << tournament.num_finished_matches() << " matches played, "
+                      << "results written to " << results_file_name << endl;
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[]) {
+  QCoreApplication app(argc, argv);
+
+  if(!parse_log_options(argc, argv)) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  if(argc > 1 && QString(argv[1]) == "--tournament") return run_tournament(app, argc, argv);
+  return run_battle(app, argc, argv);
+}
@@ -0,0 +1,189 @@
+// tournament.cpp - Tournament class implementation
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include <QtCore>
+#include <cassert>
+#include <algorithm>
+#include <stdexcept>
+#include "map.hpp"
+#include "logger.hpp"
+#include "battlethread.hpp"
+#include "tournament.hpp"
+
+using namespace std;
+using namespace team_planets;
+using namespace team_planets_engine;
+
+// Quote a CSV field if needed (the errors may span several lines)
+static QString csv_field(const QString& field) {
+  if(!field.contains(QChar(',')) && !field.contains(QChar('"')) && !field.contains(QChar('\n'))
+     && !field.contains(QChar('\r')))
+    return field;
+
+  QString quoted = field;
+  quoted.replace(QString("\""), QString("\"\""));
+  return QString("\"") + quoted + QString("\"");
+}
+
+// The maps are designed for a given number of players, the team 1 owning the first half of the starting planets
+static unsigned int num_players_per_team(const QString& map_file_name) {
+  Map map;
+  map.load(map_file_name.toStdString());
+
+  player_id max_owner = neutral_player;
+  for_each(map.planets_begin(), map.planets_end(), [&max_owner](ConstPlanetView planet) {
+    if(planet.current_owner() > max_owner) max_owner = planet.current_owner();
+  });
+
+  return max_owner < 2 ? 1 : max_owner/2;
+}
+
+Tournament::Tournament(const QStringList& maps_file_names, const QStringList& bots_file_names,
+                       const QString& results_file_name, unsigned int num_workers, QObject* parent):
+  QObject(parent), maps_file_names_(maps_file_names), bots_file_names_(bots_file_names),
+  num_workers_(num_workers != 0 ? num_workers : 1), cpu_budget_(0), turn_time_(1000), time_bank_(0),
+  adjudication_ratio_(0.0f), adjudication_turns_(0), concurrent_bots_(false), next_match_(0),
+  num_finished_matches_(0), results_file_(results_file_name) {
+}
+
+void Tournament::start() {
+  if(!results_file_.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    throw runtime_error("Unable to open tournament results file " + results_file_.fileName().toStdString() + ".");
+  results_.setDevice(&results_file_);
+  write_results_header_();
+
+  schedule_matches_();
+  ENGINE_LOG(Info, "tournament") << "Starting tournament of " << matches_.size() << " matches on " << num_workers_
+                                 << " workers...";
+
+  if(matches_.empty()) emit finished();
+  while(running_matches_.size() < num_workers_ && next_match_ < matches_.size()) start_next_match_();
+}
+
+void Tournament::schedule_matches_() {
+  matches_.clear();
+
+  for(const QString& map_file_name:maps_file_names_) {
+    Match_ match;
+    match.map_file_name = map_file_name;
+    match.num_players_per_team = num_players_per_team(map_file_name);
+
+    // Each pair of bots plays once on each side, a lonely bot plays against itself
+    for(int i = 0; i < bots_file_names_.size(); ++i) {
+      for(int j = 0; j < bots_file_names_.size(); ++j) {
+        if(i != j || bots_file_names_.size() == 1) {
+          match.team1_bot_file_name = bots_file_names_[i];
+          match.team2_bot_file_name = bots_file_names_[j];
+          matches_.push_back(match);
+        }
+      }
+    }
+  }
+}
+
+void Tournament::start_next_match_() {
+  const Match_& match = matches_[next_match_];
+
+  BattleThread* battle = new BattleThread(match.map_file_name,
+                                          match.team1_bot_file_name, match.num_players_per_team,
+                                          match.team2_bot_file_name, match.num_players_per_team, this);
+  battle->set_turn_delay(0);
+  battle->set_bot_pool(&bot_pool_);
+  battle->set_cpu_budget(cpu_budget_);
+  battle->set_turn_time(turn_time_);
+  battle->set_time_bank(time_bank_);
+  battle->set_adjudication(adjudication_ratio_, adjudication_turns_);
+  battle->set_concurrent_bots(concurrent_bots_);
+
+  RunningMatch_& running_match = running_matches_[battle];
+  running_match.match = next_match_;
+  if(!replays_directory_.isEmpty()) {
+    running_match.replay_file_name = replays_directory_ + QString("/match_%1.replay").arg(next_match_ + 1);
+    battle->set_replay_file_name(running_match.replay_file_name);
+  }
+  ++next_match_;
+
+  connect(battle, &BattleThread::error_occured, this, [this, battle](const QString& msg) {
+    running_matches_[battle].error = msg;
+  });
+  connect(battle, &QThread::finished, this, [this, battle]() {
+    match_finished_(battle);
+  });
+
+  battle->start();
+}
+
+void Tournament::match_finished_(BattleThread* battle) {
+  auto it = running_matches_.find(battle);
+  assert(it != running_matches_.end());
+
+  battle->wait();
+  write_match_results_(matches_[it->second.match], it->second, *battle);
+  ++num_finished_matches_;
+  ENGINE_LOG(Info, "tournament") << num_finished_matches_ << " of " << matches_.size() << " matches played.";
+
+  running_matches_.erase(it);
+  battle->deleteLater();
+
+  // Keeping the workers busy
+  if(next_match_ < matches_.size()) start_next_match_();
+  else if(running_matches_.empty()) emit finished();
+}
+
+void Tournament::write_results_header_() {
+  results_ << "map,team1_bot,team2_bot,players_per_team,winner,turns,adjudicated,"
+           << "team1_planets,team1_ships,team2_planets,team2_ships,replay,error" << endl;
+}
+
+void Tournament::write_match_results_(const Match_& match, const RunningMatch_& running_match,
+                                      BattleThread& battle) {
+  // Computing teams statistics
+  unsigned int team1_planets = 0, team1_ships = 0;
+  unsigned int team2_planets = 0, team2_ships = 0;
+
+  for_each(battle.players_begin(), battle.players_end(),
+           [&team1_planets, &team1_ships, &team2_planets, &team2_ships](const Player& player) {
+    if(player.team() == 1) {
+      team1_planets += player.num_planets();
+      team1_ships += player.num_ships();
+    } else {
+      team2_planets += player.num_planets();
+      team2_ships += player.num_ships();
+    }
+  });
+
+  // Writing the results line, the file is flushed to be able to follow the tournament progress
+  results_ << csv_field(match.map_file_name) << ',' << csv_field(match.team1_bot_file_name) << ','
+           << csv_field(match.team2_bot_file_name) << ',' << match.num_players_per_team << ','
+           << battle.winner() << ',' << battle.current_turn() << ',' << (battle.adjudicated() ? 1 : 0) << ','
+           << team1_planets << ',' << team1_ships << ',' << team2_planets << ',' << team2_ships << ','
+           << csv_field(running_match.replay_file_name) << ',' << csv_field(running_match.error) << endl;
+  results_.flush();
+}
@@ -0,0 +1,140 @@
+// tournament.hpp - Tournament class definition
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#ifndef _TEAMPLANETS_TEAMPLANETSENGINE_TOURNAMENT_HPP_
+#define _TEAMPLANETS_TEAMPLANETSENGINE_TOURNAMENT_HPP_
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <QTextStream>
+#include <map>
+#include <vector>
+#include "botpool.hpp"
+
+namespace team_planets_engine {
+  class BattleThread;
+
+  // Round-robin tournament between a set of bots on a set of maps. Each match is played by its own
+  // BattleThread (with its own map), at most num_workers matches are played at the same time and the
+  // results are appended to a CSV file as soon as each match is over.
+  class Tournament: public QObject {
+    Q_OBJECT
+
+  public:
+    Tournament(const QStringList& maps_file_names, const QStringList& bots_file_names,
+               const QString& results_file_name, unsigned int num_workers, QObject* parent = nullptr);
+
+    // Directory receiving the replay of each match, no replays if empty, must be set before the start
+    const QString& replays_directory() const { return replays_directory_; }
+    void set_replays_directory(const QString& replays_directory) { replays_directory_ = replays_directory; }
+
+    // CPU time budget of the bots for each turn in ms, none if null, must be set before the start
+    unsigned int cpu_budget() const { return cpu_budget_; }
+    void set_cpu_budget(unsigned int cpu_budget) { cpu_budget_ = cpu_budget; }
+
+    // Time control of the bots in ms (see BattleThread), must be set before the start
+    unsigned int turn_time() const { return turn_time_; }
+    unsigned int time_bank() const { return time_bank_; }
+    void set_time_control(unsigned int turn_time, unsigned int time_bank) {
+      turn_time_ = turn_time;
+      time_bank_ = time_bank;
+    }
+
+    // Early adjudication of the matches (see BattleThread), must be set before the start
+    void set_adjudication(float ratio, unsigned int num_turns) {
+      adjudication_ratio_ = ratio;
+      adjudication_turns_ = num_turns;
+    }
+
+    // Bots of a match asked at the same time (see BattleThread), must be set before the start
+    void set_concurrent_bots(bool concurrent_bots) { concurrent_bots_ = concurrent_bots; }
+
+    void start();
+
+    // Tournament statistics
+    std::size_t num_matches() const { return matches_.size(); }
+    std::size_t num_finished_matches() const { return num_finished_matches_; }
+
+  signals:
+    void finished();
+
+  private:
+    Q_DISABLE_COPY(Tournament)
+
+    struct Match_ {
+      QString       map_file_name;
+      QString       team1_bot_file_name;
+      QString       team2_bot_file_name;
+      unsigned int  num_players_per_team;
+    };
+
+    struct RunningMatch_ {
+      std::size_t   match;
+      QString       replay_file_name;
+      QString       error;
+    };
+
+    void schedule_matches_();
+    void start_next_match_();
+    void match_finished_(BattleThread* battle);
+
+    void write_results_header_();
+    void write_match_results_(const Match_& match, const RunningMatch_& running_match, BattleThread& battle);
+
+    // Tournament configuration
+    const QStringList   maps_file_names_;
+    const QStringList   bots_file_names_;
+    const unsigned int  num_workers_;
+    QString             replays_directory_;
+    unsigned int        cpu_budget_;
+    unsigned int        turn_time_;
+    unsigned int        time_bank_;
+    float               adjudication_ratio_;
+    unsigned int        adjudication_turns_;
+    bool                concurrent_bots_;
+
+    // Matches scheduling
+    std::vector<Match_>                     matches_;
+    std::size_t                             next_match_;
+    std::size_t                             num_finished_matches_;
+    std::map<BattleThread*, RunningMatch_>  running_matches_;
+
+    // Warm bots shared by the matches
+    BotPool                                 bot_pool_;
+
+    // Results output
+    QFile       results_file_;
+    QTextStream results_;
+  };
+}
+
+#endif
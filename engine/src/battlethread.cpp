@@ -30,66 +30,100 @@
 
 #include <QtCore>
 #include <algorithm>
-#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include "map.hpp"
+#include "botpoller.hpp"
+#include "botresponseparser.hpp"
+#include "logger.hpp"
 #include "battlethread.hpp"
 
 using namespace std;
 using namespace team_planets;
 using namespace team_planets_engine;
 
+// In CPU budget mode, the response time limit is the budget multiplied by this factor
+static const unsigned int cpu_budget_wall_time_factor = 5;
+
+// Time given to a terminated bot to exit before it is killed
+static const int bot_termination_grace_msecs = 1000;
+
+// Identifies the battles in the log
+static atomic<unsigned int> last_battle_id(0);
+
 BattleThread::BattleThread(const QString& map_file_name,
                            const QString& team1_bot_file_name, unsigned int team1_num_players,
                            const QString& team2_bot_file_name, unsigned int team2_num_players,
-                           QMutex& map_mutex, team_planets::Map& map, QObject* parent):
-  QThread(parent), stop_(false), map_file_name_(map_file_name), team1_bot_file_name_(team1_bot_file_name),
-  team1_num_players_(team1_num_players), team2_bot_file_name_(team2_bot_file_name),
-  team2_num_players_(team2_num_players), map_mutex_(map_mutex), map_(map),
-  battle_in_progress_(true), current_turn_(1), winner_(0) {
+                           QObject* parent):
+  QThread(parent), battle_id_(++last_battle_id), stop_(false), map_file_name_(map_file_name),
+  team1_bot_file_name_(team1_bot_file_name), team1_num_players_(team1_num_players),
+  team2_bot_file_name_(team2_bot_file_name), team2_num_players_(team2_num_players), turn_delay_(500),
+  bot_pool_(nullptr), cpu_budget_(0), turn_time_(1000), time_bank_(0), adjudication_ratio_(0.0f),
+  adjudication_turns_(0), concurrent_bots_(false), publish_snapshots_(false), battle_in_progress_(true),
+  current_turn_(1), winner_(0), dominating_team_(0), domination_turns_(0), adjudicated_(false) {
 }
 
 void BattleThread::run() {
-  qDebug() << "Starting new battle...";
+  ENGINE_LOG(Info, "battle", battle_id_) << "Starting new battle...";
 
   try {
     // Loading the battle map
-    map_mutex_.lock();
     map_.reset();
     map_.load(map_file_name_.toStdString());
-    qDebug() << "Loaded map from" << map_file_name_ << ":" << map_.num_planets() << " planets.";
-    map_mutex_.unlock();
+    ENGINE_LOG(Info, "battle", battle_id_) << "Loaded map from " << map_file_name_.toStdString() << ": "
+                                           << map_.num_planets() << " planets.";
+    publish_snapshot_();
     emit map_updated();
 
     // Creating the players
     create_players_();
+    for(Player& player:players_) {
+      player.set_time_bank(time_bank_);
+      player.set_ping_limit((unsigned int)response_time_limit_(player.id()).count());
+    }
     cleanup_map_();
     update_players_();
+    begin_replay_();
+    if(!profile_file_name_.isEmpty()) profiler_.open_turns_file(profile_file_name_.toStdString());
 
     // Battle main loop
     bool stop_requested = false;
     while(!stop_requested && battle_in_progress_ && current_turn_ <= 200) {
-      qDebug() << "Turn " << current_turn_ << " begins...";
-
-      // Manually process pending events
-      QCoreApplication::sendPostedEvents();
-      QCoreApplication::processEvents();
+      ENGINE_LOG(Debug, "battle", battle_id_) << "Turn " << current_turn_ << " begins...";
+      profiler_.begin_turn();
+      if(record_replay_event_(ReplayBeginTurn)) replay_put_uint32(replay_events_, current_turn_);
 
-      // Ask the bots and perform their orders
+      // Ask the bots and perform their orders, the terminated bots still running have used their grace period
+      kill_terminated_bots_();
       ask_players_();
 
       // Performing the turn
-      map_mutex_.lock();
       map_.engine_perform_turn();
-      map_mutex_.unlock();
+      record_replay_event_(ReplayPerformTurn);
+      profiler_.end_phase(TurnProfiler::TurnPerforming);
 
       // Updating players and eliminating dead ones
       update_players_();
       eliminate_dead_players_();
       battle_in_progress_ = !check_victory_();
+      if(battle_in_progress_ && check_adjudication_()) {
+        battle_in_progress_ = false;
+        adjudicated_ = true;
+        check_victory_max_turns_exceeded_();
+        ENGINE_LOG(Info, "battle", battle_id_) << "Team " << dominating_team_ << " dominates since "
+                                               << domination_turns_ << " turns, the battle is adjudicated.";
+      }
+      profiler_.end_phase(TurnProfiler::PlayersUpdate);
+      end_replay_turn_();
+      profiler_.end_phase(TurnProfiler::ReplayRecording);
 
-      // Update UI
+      // Update UI, the pause is not a part of the turn
+      publish_snapshot_();
       emit map_updated();
-      msleep(500);
+      profiler_.end_phase(TurnProfiler::Signalling);
+      profiler_.end_turn(current_turn_);
+      if(turn_delay_ != 0) msleep(turn_delay_);
 
       // Check if the thread must stop
       stop_mutex_.lock();
@@ -104,51 +138,44 @@ void BattleThread::run() {
     if(battle_in_progress_) {
       battle_in_progress_ = false;
       check_victory_max_turns_exceeded_();
+      publish_snapshot_();
       emit map_updated();
     }
+    end_replay_();
 
     // Clean up
     destroy_players_();
   } catch(const std::exception& e) {
     emit error_occured(QString(e.what()));
-    qDebug() << "ERROR:" << e.what();
-    qDebug() << "The battle was aborted due to an error!";
+    ENGINE_LOG(Error, "battle", battle_id_) << "The battle was aborted due to an error: " << e.what();
   }
 
-  if(winner_ == 1) qDebug() << "The battle is over in" << current_turn_ << "turns. Team 1 wins!";
-  else if(winner_ == 2) qDebug() << "The battle is over in" << current_turn_ << "turns. Team 2 wins!";
-  else qDebug() << "The battle is over in" << current_turn_ << "turns. No winner!";
+  // The replay of an aborted battle is kept as is
+  replay_writer_.reset();
+
+  if(winner_ != 0)
+    ENGINE_LOG(Info, "battle", battle_id_) << "The battle is over in " << current_turn_ << " turns. Team "
+                                           << winner_ << " wins!";
+  else ENGINE_LOG(Info, "battle", battle_id_) << "The battle is over in " << current_turn_ << " turns. No winner!";
 }
 
-void BattleThread::bot_error(QProcess::ProcessError error) {
-  if(error == QProcess::Crashed) {
-    // One of the bots have crashed
-    players_mutex_.lock();
-    for(player_id id = 1; id <= players_.size(); ++id) {
-      if(players_[id - 1].status() == Player::Alive && bots_[id - 1]->state() == QProcess::NotRunning) {
-        players_[id - 1].set_status(Player::Failed);
-        players_[id - 1].set_num_planets(0);
-        players_[id - 1].set_num_ships(0);
+void BattleThread::publish_snapshot_() {
+  if(!publish_snapshots_) return;
 
-        map_mutex_.lock();
-        for_each(map_.planets_begin(), map_.planets_end(), [id](Planet& planet) {
-          if(planet.current_owner() == id) planet.set_current_owner(neutral_player);
-        });
+  // A new snapshot each time, the previous ones may still be read by the user interface
+  shared_ptr<BattleSnapshot> snapshot = make_shared<BattleSnapshot>();
+  snapshot->map = map_;
+  snapshot->players = players_;
+  snapshot->battle_in_progress = battle_in_progress_;
+  snapshot->current_turn = current_turn_;
+  snapshot->winner = winner_;
 
-        map_.engine_eliminate_player_fleets(id);
-        map_mutex_.unlock();
-      }
-    }
-    players_mutex_.unlock();
-  }
+  atomic_store(&snapshot_, shared_ptr<const BattleSnapshot>(snapshot));
 }
 
 void BattleThread::create_players_() {
-  players_mutex_.lock();
   players_.clear();
 
-  qRegisterMetaType<QProcess::ProcessError>("QProcess::ProcessError");
-
   // Creating the first team
   int cur_color = 255;
   int color_step = 200/team1_num_players_;
@@ -156,13 +183,7 @@ void BattleThread::create_players_() {
     players_.push_back(Player(players_.size() + 1, 1, QColor(cur_color, 0, 0)));
     cur_color -= color_step;
 
-    qDebug() << "Starting bot " << team1_bot_file_name_ << " for player " << players_.back().id();
-    QProcess* player_process = new QProcess;
-    connect(player_process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(bot_error(QProcess::ProcessError)));
-    player_process->start(team1_bot_file_name_);
-    if(!player_process->waitForStarted(10000)) players_.back().set_status(Player::Failed);
-    bots_.push_back(player_process);
-    qDebug() << "\tprocess id = " << player_process->processId();
+    add_player_bot_(team1_bot_file_name_);
   }
 
   // Creating the second team
@@ -172,105 +193,205 @@ void BattleThread::create_players_() {
     players_.push_back(Player(players_.size() + 1, 2, QColor(0, 0, cur_color)));
     cur_color -= color_step;
 
-    qDebug() << "Starting bot " << team2_bot_file_name_ << " for player " << players_.back().id();
-    QProcess* player_process = new QProcess;
-    connect(player_process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(bot_error(QProcess::ProcessError)));
-    player_process->start(team2_bot_file_name_);
-    if(!player_process->waitForStarted(10000)) players_.back().set_status(Player::Failed);
+    add_player_bot_(team2_bot_file_name_);
+  }
+
+  // All the bots are launched, waiting for them to be started
+  for(player_id id = 1; id <= players_.size(); ++id) {
+    const bool started = bots_[id - 1] ? bots_[id - 1]->wait_for_started() : plugins_[id - 1] != nullptr;
+    if(!started) players_[id - 1].set_status(Player::Failed);
+  }
+
+  // Nothing sent yet, the first input of each bot has every planet
+  sent_planets_.assign(players_.size(), PlanetStore());
+}
+
+void BattleThread::add_player_bot_(const QString& bot_file_name) {
+  Player& player = players_.back();
+
+  if(BotPlugin::is_plugin(bot_file_name.toStdString())) {
+    // The plugins get the binary records directly, they are reset like the bots using the protocol extension
+    BotPlugin* plugin = load_plugin_(bot_file_name);
+    bots_.push_back(nullptr);
+    plugins_.push_back(plugin);
+    player.set_extensions(binary_extension | reset_extension);
+    if(plugin) ENGINE_LOG(Info, "battle", battle_id_, player.id()) << "Loaded plugin " << bot_file_name.toStdString();
+  } else {
+    BotProcess* player_process = start_bot_(bot_file_name);
     bots_.push_back(player_process);
-    qDebug() << "\tprocess id = " << player_process->processId();
+    plugins_.push_back(nullptr);
+    ENGINE_LOG(Info, "battle", battle_id_, player.id()) << "Started bot " << bot_file_name.toStdString()
+                                                        << ", process id = " << player_process->process_id();
   }
+}
+
+BotProcess* BattleThread::start_bot_(const QString& bot_file_name) {
+  const string command = bot_file_name.toStdString();
 
-  players_mutex_.unlock();
+  // Taking a warm bot if available
+  if(bot_pool_) {
+    BotProcess* bot = bot_pool_->acquire(command);
+    if(bot) return bot;
+  }
+
+  BotProcess* bot = new BotProcess;
+  bot->launch(command);
+  return bot;
+}
+
+BotPlugin* BattleThread::load_plugin_(const QString& bot_file_name) {
+  const string file_name = bot_file_name.toStdString();
+
+  // Taking a reset instance if available
+  if(bot_pool_) {
+    BotPlugin* plugin = bot_pool_->acquire_plugin(file_name);
+    if(plugin) return plugin;
+  }
+
+  BotPlugin* plugin = new BotPlugin;
+  if(!plugin->load(file_name)) {
+    delete plugin;
+    return nullptr;
+  }
+  return plugin;
 }
 
 void BattleThread::cleanup_map_() {
   // Remove unexistant players from the map
-  map_mutex_.lock();
-  for_each(map_.planets_begin(), map_.planets_end(), [this](Planet& planet) {
+  for_each(map_.planets_begin(), map_.planets_end(), [this](PlanetView planet) {
     if(planet.current_owner() > players_.size()) planet.set_current_owner(neutral_player);
   });
-  map_mutex_.unlock();
 }
 
 void BattleThread::ask_players_() {
-  players_mutex_.lock();
-
+  vector<player_id> alive_players;
   for(player_id id = 1; id <= players_.size(); ++id) {
+    if(players_[id - 1].status() == Player::Alive) alive_players.push_back(id);
+  }
+  if(alive_players.empty()) return;
+
+  // By default, each bot sees the orders and the message of the bots played before it in the same turn
+  if(concurrent_bots_) ask_bots_(alive_players);
+  else {
+    for(player_id id:alive_players) {
+      if(players_[id - 1].status() == Player::Alive) ask_bots_(vector<player_id>(1, id));
+    }
+  }
+}
+
+void BattleThread::ask_bots_(const vector<player_id>& players) {
+  // Sending the input to every bot first, so the bots think at the same time
+  const BotProcess::time_point start_time = chrono::steady_clock::now();
+  vector<BotProcess::time_point> deadlines(players_.size());
+  for(player_id id:players) deadlines[id - 1] = start_time + response_time_limit_(id);
+
+  generate_planets_input_(players);
+  profiler_.end_phase(TurnProfiler::InputGeneration);
+
+  vector<player_id>             asked_players;
+  vector<player_id>             plugin_players;
+  vector<chrono::microseconds>  start_cpu_times(players_.size());
+  for(player_id id:players) {
     if(players_[id - 1].status() == Player::Alive) {
-      const QString command = generate_bot_input_(id);
-      const QString response = perform_bot_io_(id, command);
-      process_bot_output_(id, response);
+      start_cpu_times[id - 1] = bot_cpu_time_(id);
+      if(plugins_[id - 1]) plugin_players.push_back(id);
+      else if(write_bot_input_(id, generate_bot_input_(id), deadlines[id - 1])) asked_players.push_back(id);
+      else bot_crashed_(id);
     }
   }
 
-  players_mutex_.unlock();
+  // Collecting the responses, the bots only differ by their time bank. The plugins are played once the bot
+  // processes have answered, they would else delay the reading of the processes outputs.
+  vector<BotResponseParser> responses(players_.size());
+  for(player_id id:asked_players) responses[id - 1].set_binary(uses_binary_protocol_(id));
+  collect_bots_outputs_(asked_players, start_time, deadlines, responses);
+  play_plugins_(plugin_players, responses);
+
+  asked_players.insert(asked_players.end(), plugin_players.begin(), plugin_players.end());
+  sort(asked_players.begin(), asked_players.end());
+  measure_bots_cpu_times_(asked_players, start_cpu_times);
+  profiler_.end_phase(TurnProfiler::BotsIO);
+
+  // Performing the orders in the players order
+  for(player_id id:asked_players) {
+    if(players_[id - 1].status() == Player::Alive) process_bot_output_(id, responses[id - 1]);
+  }
+  profiler_.end_phase(TurnProfiler::OutputProcessing);
 }
 
 void BattleThread::update_players_() {
-  players_mutex_.lock();
-
   // Reset the player statistics
   for(Player& player : players_) {
     player.set_num_planets(0);
     player.set_num_ships(0);
   }
 
-  // Updating
-  map_mutex_.lock();
-  for_each(map_.planets_begin(), map_.planets_end(), [this](const Planet& planet) {
-    if(planet.current_owner() != neutral_player) {
-      Player& owner = players_[planet.current_owner() - 1];
+  // Updating, only the owners and ships arrays are read
+  const vector<player_id>&    owners = map_.planets().owners();
+  const vector<unsigned int>& num_ships = map_.planets().num_ships();
+  for(size_t i = 0; i < owners.size(); ++i) {
+    if(owners[i] != neutral_player) {
+      Player& owner = players_[owners[i] - 1];
       owner.set_num_planets(owner.num_planets() + 1);
-      owner.set_num_ships(owner.num_ships() + planet.current_num_ships());
+      owner.set_num_ships(owner.num_ships() + num_ships[i]);
     }
-  });
+  }
 
   for_each(map_.fleets_begin(), map_.fleets_end(), [this](const Fleet& fleet) {
     Player& owner = players_[fleet.player() - 1];
     owner.set_num_ships(owner.num_ships() + fleet.num_ships());
   });
-  map_mutex_.unlock();
-
-  players_mutex_.unlock();
 }
 
 void BattleThread::eliminate_dead_players_() {
-  players_mutex_.lock();
-
   for(player_id id = 1; id <= players_.size(); ++id) {
     if(players_[id - 1].status() == Player::Alive && players_[id - 1].num_planets() == 0) {
       // The player is dead!
       players_[id - 1].set_status(Player::Dead);
+      record_replay_elimination_(id, ReplayPlayerDead);
 
-      // Terminating bot
-      disconnect(bots_[id - 1], 0, 0, 0);
-      bots_[id - 1]->terminate();
-      if(!bots_[id - 1]->waitForFinished(1000)) bots_[id - 1]->kill();
+      // Terminating bot, unless it will be reused by another battle (the bots are waited for at the end)
+      if(bots_[id - 1] && !bot_is_reusable_(id)) {
+        bots_[id - 1]->terminate();
+        terminated_bots_.push_back(make_pair(id, chrono::steady_clock::now()
+                                                 + chrono::milliseconds(bot_termination_grace_msecs)));
+      }
 
       // Eliminating remaining fleets
-      map_mutex_.lock();
       map_.engine_eliminate_player_fleets(id);
-      map_mutex_.unlock();
       players_[id - 1].set_num_ships(0);
     }
   }
+}
 
-  players_mutex_.unlock();
+void BattleThread::kill_terminated_bots_() {
+  // The exited bots are reaped and forgotten, a killed bot stays in the list until it is reaped
+  const BotProcess::time_point now = chrono::steady_clock::now();
+  size_t num_terminated_bots = 0;
+  for(pair<player_id, BotProcess::time_point> terminated_bot:terminated_bots_) {
+    BotProcess* const bot = bots_[terminated_bot.first - 1];
+    if(!bot->is_running()) continue;
+
+    if(now >= terminated_bot.second) {
+      ENGINE_LOG(Warning, "battle", battle_id_, terminated_bot.first) << "The terminated bot is still running, killed";
+      bot->kill();
+      terminated_bot.second = BotProcess::time_point::max();
+    }
+    terminated_bots_[num_terminated_bots++] = terminated_bot;
+  }
+  terminated_bots_.resize(num_terminated_bots);
 }
 
 bool BattleThread::check_victory_() {
   unsigned int team1_alive_players = 0;
   unsigned int team2_alive_players = 0;
 
-  players_mutex_.lock();
   for(const Player& player:players_) {
     if(player.status() == Player::Alive) {
       if(player.team() == 1) ++team1_alive_players;
       else ++team2_alive_players;
     }
   }
-  players_mutex_.unlock();
 
   if(team1_alive_players == 0 && team2_alive_players == 0) {
     // Battle is over, no winner
@@ -297,44 +418,233 @@ void BattleThread::check_victory_max_turns_exceeded_() {
   unsigned int team1_fleet = 0;
   unsigned int team2_fleet = 0;
 
-  players_mutex_.lock();
   for(const Player& player:players_) {
     if(player.team() == 1) team1_fleet += player.num_ships();
     else team2_fleet += player.num_ships();
   }
-  players_mutex_.unlock();
 
   if(team1_fleet > team2_fleet) winner_ = 1;
   else if(team2_fleet > team1_fleet) winner_ = 2;
   else winner_ = 0;
 }
 
+bool BattleThread::check_adjudication_() {
+  if(adjudication_turns_ == 0) return false;
+
+  // Ships and production of each team, the ships are already counted by update_players_
+  unsigned int ships[2] = { 0, 0 }, production[2] = { 0, 0 };
+  for(const Player& player:players_) ships[player.team() - 1] += player.num_ships();
+  for_each(map_.planets_begin(), map_.planets_end(), [this, &production](ConstPlanetView planet) {
+    if(planet.current_owner() != neutral_player)
+      production[players_[planet.current_owner() - 1].team() - 1] += planet.ship_increase();
+  });
+
+  // A team dominates when it is ahead by the ratio in both, the domination must last without interruption
+  unsigned int dominating_team = 0;
+  for(unsigned int team = 1; team <= 2; ++team) {
+    const unsigned int other = 2 - team;
+    if(ships[team - 1] > ships[other] && ships[team - 1] >= adjudication_ratio_*ships[other]
+       && production[team - 1] >= adjudication_ratio_*production[other]) dominating_team = team;
+  }
+
+  if(dominating_team != 0 && dominating_team == dominating_team_) ++domination_turns_;
+  else domination_turns_ = (dominating_team != 0) ? 1 : 0;
+  dominating_team_ = dominating_team;
+
+  return domination_turns_ >= adjudication_turns_;
+}
+
 void BattleThread::destroy_players_() {
-  qDebug() << "Terminating bots...";
-  for(QProcess* bot:bots_) {
-    disconnect(bot, 0, 0, 0);
-    bot->terminate();
-    if(!bot->waitForFinished(1000)) bot->kill();
-    delete bot;
+  // The bots acknowledging the reset go back to the pool
+  const vector<bool> reset_done = reset_bots_();
+
+  ENGINE_LOG(Info, "battle", battle_id_) << "Terminating bots...";
+  vector<BotProcess*> terminated_bots;
+  for(player_id id = 1; id <= bots_.size(); ++id) {
+    const QString& bot_file_name = (players_[id - 1].team() == 1) ? team1_bot_file_name_ : team2_bot_file_name_;
+    if(plugins_[id - 1]) {
+      if(reset_done[id - 1]) bot_pool_->release(bot_file_name.toStdString(), plugins_[id - 1]);
+      else delete plugins_[id - 1];
+    } else if(reset_done[id - 1]) bot_pool_->release(bot_file_name.toStdString(), bots_[id - 1]);
+    else if(bots_[id - 1]) terminated_bots.push_back(bots_[id - 1]);
   }
 
+  BotProcess::terminate_all(terminated_bots, bot_termination_grace_msecs);
+  for(BotProcess* bot:terminated_bots) delete bot;
   bots_.clear();
+  plugins_.clear();
+  terminated_bots_.clear();
 }
 
-QString BattleThread::generate_bot_input_(player_id id) {
-  stringstream cmd;
+bool BattleThread::bot_is_reusable_(player_id id) const {
+  return bot_pool_ && players_[id - 1].status() != Player::Failed
+         && (players_[id - 1].extensions() & reset_extension);
+}
 
-  map_mutex_.lock();
-  for_each(map_.planets_begin(), map_.planets_end(), [&cmd](const Planet& planet) {
-    cmd << planet << endl;
-  });
-  map_mutex_.unlock();
+vector<bool> BattleThread::reset_bots_() {
+  const BotProcess::time_point deadline = chrono::steady_clock::now() + chrono::milliseconds(1000);
+
+  // Sending the reset request in the protocol currently used by each bot, the plugins are reset directly
+  vector<bool>      reset_done(bots_.size(), false);
+  vector<player_id> reset_players;
+  for(player_id id = 1; id <= bots_.size(); ++id) {
+    if(plugins_[id - 1]) {
+      if(bot_is_reusable_(id)) reset_done[id - 1] = plugins_[id - 1]->reset();
+    } else if(bot_is_reusable_(id)) {
+      string request = "R\n.\n";
+      if(uses_binary_protocol_(id)) {
+        BinaryInputHeader header;
+        header.size = sizeof(header);
+        header.flags = binary_reset;
+        header.myself = id;
+        header.message = 0;
+        header.num_planets = 0;
+        request.assign(reinterpret_cast<const char*>(&header), sizeof(header));
+      }
+
+      if(bots_[id - 1]->write(request, deadline)) reset_players.push_back(id);
+    }
+  }
+
+  // Waiting for the acknowledgments, always in text
+  vector<BotResponseParser>       responses(players_.size());
+  vector<BotProcess::time_point>  end_times(players_.size());
+  read_bots_outputs_(reset_players, vector<BotProcess::time_point>(players_.size(), deadline), responses, end_times);
+
+  for(player_id id:reset_players) reset_done[id - 1] = responses[id - 1].is_complete();
+  return reset_done;
+}
+
+protocol_extensions BattleThread::offered_extensions_() const {
+  // The bots are only reset if they can be reused
+  return delta_extension | binary_extension | (bot_pool_ ? reset_extension : no_extensions)
+         | (time_bank_ != 0 ? time_bank_extension : no_extensions);
+}
+
+// The extensions are accepted in the first output, they apply from the second input
+bool BattleThread::uses_binary_protocol_(player_id id) const {
+  return players_[id - 1].extensions() & binary_extension;
+}
+
+BattleThread::PlanetsInput_ BattleThread::planets_input_kind_(player_id id) const {
+  const bool delta = players_[id - 1].extensions() & delta_extension;
+
+  if(uses_binary_protocol_(id)) return delta ? DeltaBinaryInput : FullBinaryInput;
+  else return delta ? DeltaTextInput : FullTextInput;
+}
+
+void BattleThread::generate_planets_input_(const vector<player_id>& players) {
+  // Only the needed versions of the planets input are generated
+  bool needed[NumPlanetsInputs] = { false, false, false, false };
+  for(player_id id:players) {
+    if(players_[id - 1].status() == Player::Alive) needed[planets_input_kind_(id)] = true;
+  }
+
+  for(int kind = 0; kind < NumPlanetsInputs; ++kind) {
+    planets_inputs_[kind].clear();
+    planets_inputs_sizes_[kind] = 0;
+  }
+
+  // The planets changed since the state last sent, compared on the owners and ships arrays. The bots asked
+  // together were always sent the same states, the first one gives the base.
+  const PlanetStore& planets = map_.planets();
+  const PlanetStore& sent_planets = sent_planets_[players.front() - 1];
+  const bool         first_input = sent_planets.size() != planets.size();
+  vector<bool>       changed(planets.size(), first_input);
+  if(!first_input) {
+    for(size_t i = 0; i < planets.size(); ++i) {
+      changed[i] = planets.owners()[i] != sent_planets.owners()[i]
+                   || planets.num_ships()[i] != sent_planets.num_ships()[i];
+    }
+  }
+
+  char line[128];
+  for(size_t i = 0; i < planets.size(); ++i) {
+    const ConstPlanetView planet = planets[i];
+    if(needed[FullTextInput]) {
+      // Same format as the Planet output operator
+      const int size = snprintf(line, sizeof(line), "P %u %g %g %u %u %u\n", planet.id(),
+                                planet.location().x(), planet.location().y(), planet.ship_increase(),
+                                planet.current_owner(), planet.current_num_ships());
+      planets_inputs_[FullTextInput].append(line, (size_t)size);
+      ++planets_inputs_sizes_[FullTextInput];
+    }
 
-  cmd << "M " << find_team_message(id) << endl;
-  cmd << "Y " << id << endl;
-  cmd << "." << endl;
+    if(needed[FullBinaryInput]) {
+      BinaryPlanet record;
+      record.id = planet.id();
+      record.x = planet.location().x();
+      record.y = planet.location().y();
+      record.ship_increase = planet.ship_increase();
+      record.owner = planet.current_owner();
+      record.num_ships = planet.current_num_ships();
+      planets_inputs_[FullBinaryInput].append(reinterpret_cast<const char*>(&record), sizeof(record));
+      ++planets_inputs_sizes_[FullBinaryInput];
+    }
+
+    if(needed[DeltaTextInput] && changed[i]) {
+      const int size = snprintf(line, sizeof(line), "D %u %u %u\n", planet.id(),
+                                planet.current_owner(), planet.current_num_ships());
+      planets_inputs_[DeltaTextInput].append(line, (size_t)size);
+      ++planets_inputs_sizes_[DeltaTextInput];
+    }
+
+    if(needed[DeltaBinaryInput] && changed[i]) {
+      BinaryPlanetDelta record;
+      record.id = planet.id();
+      record.owner = planet.current_owner();
+      record.num_ships = planet.current_num_ships();
+      planets_inputs_[DeltaBinaryInput].append(reinterpret_cast<const char*>(&record), sizeof(record));
+      ++planets_inputs_sizes_[DeltaBinaryInput];
+    }
+  }
 
-  return QString::fromStdString(cmd.str());
+  // Keeping the sent state, base of the next delta
+  for(player_id id:players) sent_planets_[id - 1] = planets;
+
+  if(needed[FullTextInput])
+    ENGINE_LOG(Debug, "protocol", battle_id_) << "Planets input:\n" << planets_inputs_[FullTextInput];
+  if(needed[DeltaTextInput])
+    ENGINE_LOG(Debug, "protocol", battle_id_) << "Planets delta input:\n" << planets_inputs_[DeltaTextInput];
+}
+
+string BattleThread::generate_bot_input_(player_id id) {
+  if(uses_binary_protocol_(id)) {
+    // The binary frame header, followed by the planets records
+    const PlanetsInput_ kind = planets_input_kind_(id);
+
+    BinaryInputHeader header;
+    header.size = (uint32_t)(sizeof(header) + planets_inputs_[kind].size());
+    header.flags = (kind == FullBinaryInput) ? binary_full_planets : 0;
+    header.myself = id;
+    header.message = find_team_message(id);
+    header.num_planets = planets_inputs_sizes_[kind];
+
+    string input;
+    if(sends_time_control_(id)) {
+      BinaryTimeBank time_control;
+      time_control.turn_time = turn_time_;
+      time_control.time_bank = players_[id - 1].time_bank();
+
+      header.size += sizeof(time_control);
+      header.flags |= binary_time_bank;
+      input.assign(reinterpret_cast<const char*>(&header), sizeof(header));
+      input.append(reinterpret_cast<const char*>(&time_control), sizeof(time_control));
+    } else input.assign(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    return input;
+  }
+
+  char input[96];
+  int size = snprintf(input, sizeof(input), "M %u\nY %u\n", find_team_message(id), id);
+  if(sends_time_control_(id))
+    size += snprintf(input + size, sizeof(input) - size, "T %u %u\n", turn_time_, players_[id - 1].time_bank());
+
+  // The protocol extensions are offered on the first turn only
+  if(current_turn_ == 1) size += snprintf(input + size, sizeof(input) - size, "X %u\n", offered_extensions_());
+  size += snprintf(input + size, sizeof(input) - size, ".\n");
+
+  return string(input, (size_t)size);
 }
 
 uint32_t BattleThread::find_team_message(player_id id) {
@@ -352,71 +662,335 @@ uint32_t BattleThread::find_team_message(player_id id) {
   else return players_[id - 1].message();
 }
 
-QString BattleThread::perform_bot_io_(player_id id, const QString& bot_input) {
-  // Writing the input to the bot
-  qDebug() << "Input for player " << id << ":";
-  qDebug() << bot_input;
+// The time control is sent on the first turn, the bots unaware of it ignore the tag
+bool BattleThread::sends_time_control_(player_id id) const {
+  return time_bank_ != 0 && (current_turn_ == 1 || (players_[id - 1].extensions() & time_bank_extension));
+}
 
-  QTextStream bot_io(bots_[id - 1]);
-  bot_io << bot_input;
-  bot_io.flush();
+chrono::milliseconds BattleThread::response_time_limit_(player_id id) const {
+  const unsigned int time_limit = (cpu_budget_ != 0) ? cpu_budget_wall_time_factor*cpu_budget_ : turn_time_;
+  return chrono::milliseconds(time_limit + players_[id - 1].time_bank());
+}
 
-  // Reading the bot output
-  qint64 start_time = QDateTime::currentMSecsSinceEpoch();
-  qint64 end_time;
+void BattleThread::update_time_bank_(player_id id) {
+  if(time_bank_ == 0) return;
 
-  qDebug() << "Output of player " << id << ":";
-  QString response;
-  QString tmp;
-  do {
-    bots_[id - 1]->waitForReadyRead(100);
-    tmp = bot_io.readAll();
-    end_time = QDateTime::currentMSecsSinceEpoch();
+  // The time used beyond the turn time is taken from the bank, the unused turn time refills it
+  Player& player = players_[id - 1];
+  if(player.ping() > turn_time_) {
+    const unsigned int excess = player.ping() - turn_time_;
+    player.set_time_bank(excess < player.time_bank() ? player.time_bank() - excess : 0);
+  } else player.set_time_bank(min(time_bank_, player.time_bank() + (turn_time_ - player.ping())));
+}
 
-    response += tmp;
-  } while(tmp[tmp.size() - 2] != QChar('.') && end_time - start_time <= 1000);
+bool BattleThread::write_bot_input_(player_id id, const string& bot_input, BotProcess::time_point deadline) {
+  const string& planets_input = planets_inputs_[planets_input_kind_(id)];
+  const bool    binary = uses_binary_protocol_(id);
+
+  if(binary) {
+    ENGINE_LOG(Debug, "protocol", battle_id_, id) << "Input: binary frame of "
+                                                  << bot_input.size() + planets_input.size() << " bytes";
+  } else ENGINE_LOG(Debug, "protocol", battle_id_, id) << "Input:\n" << bot_input;
+
+  // The shared planets block and the player specific part (a binary header comes first)
+  iovec buffers[2];
+  iovec& planets_buffer = binary ? buffers[1] : buffers[0];
+  iovec& player_buffer = binary ? buffers[0] : buffers[1];
+  planets_buffer.iov_base = const_cast<char*>(planets_input.data());
+  planets_buffer.iov_len = planets_input.size();
+  player_buffer.iov_base = const_cast<char*>(bot_input.data());
+  player_buffer.iov_len = bot_input.size();
+
+  return bots_[id - 1]->write(buffers, 2, deadline);
+}
 
-  qDebug() << response;
-  players_[id - 1].set_ping(end_time - start_time);
-  if(end_time - start_time >= 1000) kill_misbehaving_bot_(id);
+void BattleThread::collect_bots_outputs_(const vector<player_id>& players, BotProcess::time_point start_time,
+                                         const vector<BotProcess::time_point>& deadlines,
+                                         vector<BotResponseParser>& responses) {
+  vector<BotProcess::time_point> end_times(players_.size());
+  read_bots_outputs_(players, deadlines, responses, end_times);
+
+  for(player_id id:players) {
+    // The bots without end time have exceeded their time
+    const bool timed_out = (end_times[id - 1] == BotProcess::time_point());
+    const BotProcess::time_point end_time = timed_out ? chrono::steady_clock::now() : end_times[id - 1];
+    const auto ping = chrono::duration_cast<chrono::milliseconds>(end_time - start_time);
+    players_[id - 1].set_ping((unsigned int)ping.count());
+
+    if(timed_out) {
+      ENGINE_LOG(Debug, "protocol", battle_id_, id) << "Output: incomplete";
+      kill_misbehaving_bot_(id);
+    } else if(!responses[id - 1].is_over()) {
+      ENGINE_LOG(Debug, "protocol", battle_id_, id) << "Output: closed";
+      bot_crashed_(id);
+    } else {
+      ENGINE_LOG(Debug, "protocol", battle_id_, id) << "Output: " << responses[id - 1].fleets().size() << " fleets";
+    }
 
-  return response;
+    if(players_[id - 1].status() == Player::Alive) update_time_bank_(id);
+  }
 }
 
-void BattleThread::process_bot_output_(player_id id, const QString& bot_output) {
-  stringstream in;
-  in.str(bot_output.toStdString());
+void BattleThread::read_bots_outputs_(const vector<player_id>& players, const vector<BotProcess::time_point>& deadlines,
+                                      vector<BotResponseParser>& responses, vector<BotProcess::time_point>& end_times) {
+  BotPoller poller;
+  for(player_id id:players) poller.add(*bots_[id - 1], id);
 
-  string tag;
-  do {
-    in >> tag;
-
-    if(tag == string("F")) {
-      Fleet fleet;
-      in >> fleet;
-
-      map_mutex_.lock();
-      try {
-        map_.engine_launch_fleet(id, fleet.source(), fleet.destination(), fleet.num_ships());
-      } catch(const exception& e) {
-        qDebug() << "BOT ERROR: " << e.what() << endl;
-        kill_misbehaving_bot_(id);
+  // Reading the outputs as soon as they arrive, the end time is set once the output is over or closed
+  vector<player_id> pending_players(players);
+  char              buffer[4096];
+  vector<player_id> ready_players;
+
+  // The bots having output left from their previous response are read first, without waiting
+  for(player_id id:players) {
+    if(bots_[id - 1]->has_unread_output()) ready_players.push_back(id);
+  }
+
+  while(!pending_players.empty()) {
+    // Waiting until the closest deadline, the bots having exceeded their deadline are given up
+    const BotProcess::time_point now = chrono::steady_clock::now();
+    pending_players.erase(remove_if(pending_players.begin(), pending_players.end(),
+                                    [this, &poller, &deadlines, now](player_id id) {
+      if(deadlines[id - 1] > now) return false;
+      poller.remove(*bots_[id - 1]);
+      return true;
+    }), pending_players.end());
+    if(pending_players.empty()) break;
+
+    if(ready_players.empty()) {
+      BotProcess::time_point deadline = deadlines[pending_players.front() - 1];
+      for(player_id id:pending_players) deadline = min(deadline, deadlines[id - 1]);
+      poller.wait(deadline, ready_players);
+    }
+
+    for(player_id id:ready_players) {
+      // Parsing the chunks as they are read, until the terminating dot
+      BotResponseParser& response = responses[id - 1];
+      bool bot_is_alive = true;
+      while(!response.is_over()) {
+        const ssize_t num_read = bots_[id - 1]->read(buffer, sizeof(buffer));
+        if(num_read < 0) bot_is_alive = false;
+        if(num_read <= 0) break;
+
+        // The output following the response is kept for the next one, a bot must wait for its input
+        const size_t num_consumed = response.feed(buffer, (size_t)num_read);
+        if(num_consumed < (size_t)num_read) {
+          ENGINE_LOG(Warning, "protocol", battle_id_, id) << "Output after the end of the response ("
+                                                           << (size_t)num_read - num_consumed << " bytes)";
+          bots_[id - 1]->unread(buffer + num_consumed, (size_t)num_read - num_consumed);
+        }
       }
-      map_mutex_.unlock();
+
+      if(!bot_is_alive || response.is_over()) {
+        end_times[id - 1] = chrono::steady_clock::now();
+        poller.remove(*bots_[id - 1]);
+        pending_players.erase(find(pending_players.begin(), pending_players.end(), id));
+      }
+    }
+    ready_players.clear();
+  }
+}
+
+void BattleThread::play_plugins_(const vector<player_id>& players, vector<BotResponseParser>& responses) {
+  const BinaryPlanet* planets = reinterpret_cast<const BinaryPlanet*>(planets_inputs_[FullBinaryInput].data());
+
+  for(player_id id:players) {
+    const BotProcess::time_point start_time = chrono::steady_clock::now();
+
+    teamplanets_turn_input input;
+    input.myself = id;
+    input.message = find_team_message(id);
+    input.turn_time = (time_bank_ != 0) ? turn_time_ : 0;
+    input.time_bank = (time_bank_ != 0) ? players_[id - 1].time_bank() : 0;
+    input.num_planets = planets_inputs_sizes_[FullBinaryInput];
+    input.planets = planets;
+    ENGINE_LOG(Debug, "protocol", battle_id_, id) << "Input: " << input.num_planets << " planets records";
+
+    teamplanets_turn_output output;
+    const bool played = plugins_[id - 1]->play_turn(input, output);
+    const auto ping = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start_time);
+    players_[id - 1].set_ping((unsigned int)ping.count());
+
+    // A plugin can't be interrupted, its late orders are ignored
+    if(!played) {
+      ENGINE_LOG(Debug, "protocol", battle_id_, id) << "Output: failed";
+      bot_crashed_(id);
+    } else if(ping > response_time_limit_(id)) {
+      ENGINE_LOG(Debug, "protocol", battle_id_, id) << "Output: late";
+      kill_misbehaving_bot_(id);
+    } else {
+      responses[id - 1].set_output(output.message, output.orders, output.num_orders);
+      ENGINE_LOG(Debug, "protocol", battle_id_, id) << "Output: " << responses[id - 1].fleets().size() << " fleets";
     }
 
-    if(tag == string("M")) {
-      uint32_t msg;
-      in >> msg;
-      players_[id - 1].set_message(msg);
+    if(players_[id - 1].status() == Player::Alive) update_time_bank_(id);
+  }
+}
+
+chrono::microseconds BattleThread::bot_cpu_time_(player_id id) const {
+  return plugins_[id - 1] ? plugins_[id - 1]->cpu_time() : bots_[id - 1]->cpu_time();
+}
+
+void BattleThread::measure_bots_cpu_times_(const vector<player_id>& players,
+                                           const vector<chrono::microseconds>& start_cpu_times) {
+  for(player_id id:players) {
+    if(players_[id - 1].status() != Player::Alive) continue;
+
+    const chrono::microseconds cpu_time = bot_cpu_time_(id) - start_cpu_times[id - 1];
+    const auto cpu_msecs = chrono::duration_cast<chrono::milliseconds>(cpu_time).count();
+    players_[id - 1].set_cpu_time(cpu_msecs > 0 ? (unsigned int)cpu_msecs : 0);
+
+    // The orders of a bot exceeding its budget are ignored, as the late ones
+    if(cpu_budget_ != 0 && players_[id - 1].cpu_time() > cpu_budget_) {
+      ENGINE_LOG(Warning, "battle", battle_id_, id) << "The player have exceeded its CPU budget";
+      kill_misbehaving_bot_(id);
     }
-  } while(tag != string("."));
+  }
+}
+
+void BattleThread::process_bot_output_(player_id id, const BotResponseParser& bot_output) {
+  // Only a rejected order is dropped, the other orders of the bot are still performed
+  for(const Fleet& fleet:bot_output.fleets()) {
+    try {
+      map_.engine_launch_fleet(id, fleet.source(), fleet.destination(), fleet.num_ships());
+
+      if(record_replay_event_(ReplayLaunch)) {
+        replay_put_uint32(replay_events_, id);
+        replay_put_uint32(replay_events_, fleet.source());
+        replay_put_uint32(replay_events_, fleet.destination());
+        replay_put_uint32(replay_events_, fleet.num_ships());
+      }
+    } catch(const exception& e) {
+      ENGINE_LOG(Warning, "battle", battle_id_, id) << "Invalid order: " << e.what();
+      kill_misbehaving_bot_(id);
+    }
+  }
+
+  if(bot_output.has_message() && bot_output.message() != players_[id - 1].message()) {
+    players_[id - 1].set_message(bot_output.message());
+
+    if(record_replay_event_(ReplayMessage)) {
+      replay_put_uint32(replay_events_, id);
+      replay_put_uint32(replay_events_, bot_output.message());
+    }
+  }
+  if(current_turn_ == 1 && bot_output.has_extensions())
+    players_[id - 1].set_extensions(bot_output.extensions() & offered_extensions_());
+
+  if(bot_output.has_error()) {
+    ENGINE_LOG(Warning, "battle", battle_id_, id) << "Malformed output";
+    kill_misbehaving_bot_(id);
+  }
 }
 
 void BattleThread::kill_misbehaving_bot_(player_id id) {
   if(players_[id - 1].status() == Player::Alive) {
-    qDebug() << "Player " << id <<" was terminated!";
-    bots_[id - 1]->kill();
+    ENGINE_LOG(Warning, "battle", battle_id_, id) << "The player was terminated!";
+    if(bots_[id - 1]) bots_[id - 1]->kill();
     players_[id - 1].set_status(Player::Failed);
+    record_replay_elimination_(id, ReplayPlayerKilled);
+  }
+}
+
+void BattleThread::bot_crashed_(player_id id) {
+  if(players_[id - 1].status() == Player::Alive) {
+    ENGINE_LOG(Warning, "battle", battle_id_, id) << "The player have crashed!";
+    players_[id - 1].set_status(Player::Failed);
+    record_replay_elimination_(id, ReplayPlayerCrashed);
+    players_[id - 1].set_num_planets(0);
+    players_[id - 1].set_num_ships(0);
+
+    // The planets of a crashed bot are released
+    for_each(map_.planets_begin(), map_.planets_end(), [id](PlanetView planet) {
+      if(planet.current_owner() == id) planet.set_current_owner(neutral_player);
+    });
+
+    map_.engine_eliminate_player_fleets(id);
+  }
+}
+
+void BattleThread::begin_replay_() {
+  if(replay_file_name_.isEmpty()) return;
+  replay_writer_.reset(new ReplayWriter(replay_file_name_.toStdString()));
+
+  // The battle configuration and the initial map
+  replay_events_.clear();
+  replay_events_.append(replay_magic, sizeof(replay_magic));
+  replay_put_uint32(replay_events_, replay_version);
+  replay_put_string(replay_events_, map_file_name_.toStdString());
+  replay_put_string(replay_events_, team1_bot_file_name_.toStdString());
+  replay_put_uint32(replay_events_, team1_num_players_);
+  replay_put_string(replay_events_, team2_bot_file_name_.toStdString());
+  replay_put_uint32(replay_events_, team2_num_players_);
+
+  // The holes in the planets IDs are skipped
+  const auto num_planets = count_if(map_.planets_begin(), map_.planets_end(), [](ConstPlanetView planet) {
+    return planet.id() != 0;
+  });
+  replay_put_uint32(replay_events_, (uint32_t)num_planets);
+  for_each(map_.planets_begin(), map_.planets_end(), [this](ConstPlanetView planet) {
+    if(planet.id() == 0) return;
+
+    replay_put_uint32(replay_events_, planet.id());
+    replay_put_float(replay_events_, planet.location().x());
+    replay_put_float(replay_events_, planet.location().y());
+    replay_put_uint32(replay_events_, planet.ship_increase());
+    replay_put_uint32(replay_events_, planet.current_owner());
+    replay_put_uint32(replay_events_, planet.current_num_ships());
+  });
+  replay_planets_ = map_.planets();
+
+  // The bots which failed to start are out from the beginning
+  for(player_id id = 1; id <= players_.size(); ++id) {
+    if(players_[id - 1].status() == Player::Failed) record_replay_elimination_(id, ReplayPlayerKilled);
+  }
+
+  replay_writer_->write(replay_events_);
+}
+
+bool BattleThread::record_replay_event_(ReplayEvent event) {
+  if(!replay_writer_) return false;
+
+  replay_put_uint8(replay_events_, (uint8_t)event);
+  return true;
+}
+
+void BattleThread::record_replay_elimination_(player_id id, ReplayEliminationReason reason) {
+  if(record_replay_event_(ReplayEliminate)) {
+    replay_put_uint32(replay_events_, id);
+    replay_put_uint32(replay_events_, reason);
+  }
+}
+
+void BattleThread::end_replay_turn_() {
+  if(!replay_writer_) return;
+
+  // The planets changed by the turn, the writer takes the events of the whole turn at once
+  const PlanetStore&          planets = map_.planets();
+  vector<player_id>&          replay_owners = replay_planets_.owners();
+  vector<unsigned int>&       replay_num_ships = replay_planets_.num_ships();
+  for(size_t i = 0; i < planets.size(); ++i) {
+    if(planets.owners()[i] != replay_owners[i] || planets.num_ships()[i] != replay_num_ships[i]) {
+      replay_put_uint8(replay_events_, ReplayPlanet);
+      replay_put_uint32(replay_events_, planets.ids()[i]);
+      replay_put_uint32(replay_events_, planets.owners()[i]);
+      replay_put_uint32(replay_events_, planets.num_ships()[i]);
+      replay_owners[i] = planets.owners()[i];
+      replay_num_ships[i] = planets.num_ships()[i];
+    }
+  }
+
+  replay_writer_->write(replay_events_);
+}
+
+void BattleThread::end_replay_() {
+  if(record_replay_event_(ReplayEndBattle)) {
+    replay_put_uint32(replay_events_, current_turn_);
+    replay_put_uint32(replay_events_, winner_);
+    replay_writer_->write(replay_events_);
+
+    // Waiting for the file to be complete
+    replay_writer_->close();
+    replay_writer_.reset();
   }
 }
@@ -34,15 +34,32 @@
 #include <QThread>
 #include <QMutex>
 #include <QString>
-#include <QProcess>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
+#include "map.hpp"
 #include "player.hpp"
-
-namespace team_planets { class Map; }
+#include "botprocess.hpp"
+#include "botplugin.hpp"
+#include "botpool.hpp"
+#include "botresponseparser.hpp"
+#include "replay.hpp"
+#include "replaywriter.hpp"
+#include "turnprofiler.hpp"
 
 namespace team_planets_engine {
+  // State of a battle published by its thread after each turn, never modified once published
+  struct BattleSnapshot {
+    team_planets::Map   map;
+    std::vector<Player> players;
+    bool                battle_in_progress;
+    unsigned int        current_turn;
+    unsigned int        winner;
+  };
+
   class BattleThread: public QThread {
     Q_OBJECT
 
@@ -54,10 +71,55 @@ namespace team_planets_engine {
 
     BattleThread(const QString& map_file_name, const QString& team1_bot_file_name, unsigned int team1_num_players,
                  const QString& team2_bot_file_name, unsigned int team2_num_players,
-                 QMutex& map_mutex, team_planets::Map& map, QObject* parent = nullptr);
+                 QObject* parent = nullptr);
 
     void stop() { stop_mutex_.lock(); stop_ = true; stop_mutex_.unlock(); }
 
+    // Pause between two turns, must be set before the thread start
+    unsigned long turn_delay() const { return turn_delay_; }
+    void set_turn_delay(unsigned long turn_delay) { turn_delay_ = turn_delay; }
+
+    // Pool of warm bots to take the bots from and give them back, must be set before the thread start
+    BotPool* bot_pool() const { return bot_pool_; }
+    void set_bot_pool(BotPool* bot_pool) { bot_pool_ = bot_pool; }
+
+    // CPU time a bot may use each turn in ms, the response time is then only limited to stop the hanging bots.
+    // With a null budget (the default), the bots are limited by their response time only. Must be set before
+    // the thread start.
+    unsigned int cpu_budget() const { return cpu_budget_; }
+    void set_cpu_budget(unsigned int cpu_budget) { cpu_budget_ = cpu_budget; }
+
+    // Time control in ms: the time allowed to the bots for each turn, and the time bank they can draw from when
+    // they need more time (refilled by the turn time they don't use). Must be set before the thread start.
+    unsigned int turn_time() const { return turn_time_; }
+    void set_turn_time(unsigned int turn_time) { turn_time_ = turn_time; }
+    unsigned int time_bank() const { return time_bank_; }
+    void set_time_bank(unsigned int time_bank) { time_bank_ = time_bank; }
+
+    // Early adjudication: the battle is over once a team has held both ratio times the ships and ratio times the
+    // production of the other team for num_turns consecutive turns, it wins as on the turns limit. Disabled by
+    // default (null number of turns), must be set before the thread start.
+    float adjudication_ratio() const { return adjudication_ratio_; }
+    unsigned int adjudication_turns() const { return adjudication_turns_; }
+    void set_adjudication(float ratio, unsigned int num_turns) {
+      adjudication_ratio_ = ratio;
+      adjudication_turns_ = num_turns;
+    }
+
+    // Concurrent bots: every bot is asked at the same time, so a bot no longer sees the orders and the message
+    // of the bots before it in the same turn. Disabled by default (the bots are asked one after the other),
+    // must be set before the thread start.
+    bool concurrent_bots() const { return concurrent_bots_; }
+    void set_concurrent_bots(bool concurrent_bots) { concurrent_bots_ = concurrent_bots; }
+
+    // Replay file recording the battle, none if empty, must be set before the thread start
+    const QString& replay_file_name() const { return replay_file_name_; }
+    void set_replay_file_name(const QString& replay_file_name) { replay_file_name_ = replay_file_name; }
+
+    // CSV file receiving the duration of each turn phase, none if empty, must be set before the thread start
+    const QString& profile_file_name() const { return profile_file_name_; }
+    void set_profile_file_name(const QString& profile_file_name) { profile_file_name_ = profile_file_name; }
+
     // Battle configuration statistics
     const QString& map_file_name() const { return map_file_name_; }
     const QString& team1_bot_file_name() const { return team1_bot_file_name_; }
@@ -65,10 +127,16 @@ namespace team_planets_engine {
     const QString& team2_bot_file_name() const { return team2_bot_file_name_; }
     unsigned int team2_num_players() const { return team2_num_players_; }
 
-    // Players list accessors
-    void lock_players() { players_mutex_.lock(); }
-    void unlock_players() { players_mutex_.unlock(); }
+    // Snapshots publication for a user interface watching the battle, disabled by default so the headless
+    // battles don't copy their state each turn, must be set before the thread start
+    bool publish_snapshots() const { return publish_snapshots_; }
+    void set_publish_snapshots(bool publish_snapshots) { publish_snapshots_ = publish_snapshots; }
 
+    // Last published state of the battle, null before the map is loaded or if the snapshots are not published.
+    // The snapshots are immutable, so they are used from any thread without locking while the battle goes on.
+    std::shared_ptr<const BattleSnapshot> snapshot() const { return std::atomic_load(&snapshot_); }
+
+    // Players list accessors, only valid once the thread is finished (else use the snapshot)
     std::size_t num_players() const { return players_.size(); }
     const Player& player(team_planets::player_id id) const { assert(id != 0); return players_[id - 1]; }
     player_const_iterator players_begin() const { return players_.begin(); }
@@ -78,6 +146,10 @@ namespace team_planets_engine {
     bool battle_in_progress() const { return battle_in_progress_; }
     unsigned int current_turn() const { return current_turn_; }
     unsigned int winner() const { return winner_; }
+    bool adjudicated() const { return adjudicated_; }
+
+    // Time spent in each phase of the turns, only valid once the thread is finished
+    const TurnProfiler& profiler() const { return profiler_; }
 
   signals:
     void map_updated();
@@ -86,27 +158,63 @@ namespace team_planets_engine {
   protected:
     virtual void run();
 
-  private slots:
-    void bot_error(QProcess::ProcessError error);
-
   private:
     Q_DISABLE_COPY(BattleThread)
 
     void create_players_();
+    void add_player_bot_(const QString& bot_file_name);
+    BotProcess* start_bot_(const QString& bot_file_name);
+    BotPlugin* load_plugin_(const QString& bot_file_name);
     void cleanup_map_();
     void ask_players_();
+    void ask_bots_(const std::vector<team_planets::player_id>& players);
     void update_players_();
     void eliminate_dead_players_();
+    void kill_terminated_bots_();
     bool check_victory_();
     void check_victory_max_turns_exceeded_();
+    bool check_adjudication_();
     void destroy_players_();
+    bool bot_is_reusable_(team_planets::player_id id) const;
+    std::vector<bool> reset_bots_();
 
-    QString generate_bot_input_(team_planets::player_id id);
+    enum PlanetsInput_ { FullTextInput, DeltaTextInput, FullBinaryInput, DeltaBinaryInput, NumPlanetsInputs };
+
+    team_planets::protocol_extensions offered_extensions_() const;
+    bool uses_binary_protocol_(team_planets::player_id id) const;
+    PlanetsInput_ planets_input_kind_(team_planets::player_id id) const;
+    void generate_planets_input_(const std::vector<team_planets::player_id>& players);
+    std::string generate_bot_input_(team_planets::player_id id);
     uint32_t find_team_message(team_planets::player_id id);
-    QString perform_bot_io_(team_planets::player_id id, const QString& bot_input);
-    void process_bot_output_(team_planets::player_id id, const QString& bot_output);
+    bool sends_time_control_(team_planets::player_id id) const;
+    std::chrono::milliseconds response_time_limit_(team_planets::player_id id) const;
+    void update_time_bank_(team_planets::player_id id);
+    bool write_bot_input_(team_planets::player_id id, const std::string& bot_input, BotProcess::time_point deadline);
+    void collect_bots_outputs_(const std::vector<team_planets::player_id>& players, BotProcess::time_point start_time,
+                               const std::vector<BotProcess::time_point>& deadlines,
+                               std::vector<BotResponseParser>& responses);
+    void read_bots_outputs_(const std::vector<team_planets::player_id>& players,
+                            const std::vector<BotProcess::time_point>& deadlines,
+                            std::vector<BotResponseParser>& responses, std::vector<BotProcess::time_point>& end_times);
+    void play_plugins_(const std::vector<team_planets::player_id>& players, std::vector<BotResponseParser>& responses);
+    std::chrono::microseconds bot_cpu_time_(team_planets::player_id id) const;
+    void measure_bots_cpu_times_(const std::vector<team_planets::player_id>& players,
+                                 const std::vector<std::chrono::microseconds>& start_cpu_times);
+    void process_bot_output_(team_planets::player_id id, const BotResponseParser& bot_output);
 
     void kill_misbehaving_bot_(team_planets::player_id id);
+    void bot_crashed_(team_planets::player_id id);
+
+    void begin_replay_();
+    bool record_replay_event_(ReplayEvent event);
+    void record_replay_elimination_(team_planets::player_id id, ReplayEliminationReason reason);
+    void end_replay_turn_();
+    void end_replay_();
+
+    void publish_snapshot_();
+
+    // Identifies the battle in the log
+    const unsigned int battle_id_;
 
     // Thread management data
     QMutex  stop_mutex_;
@@ -118,20 +226,51 @@ namespace team_planets_engine {
     const unsigned int team1_num_players_;
     const QString team2_bot_file_name_;
     const unsigned int team2_num_players_;
+    unsigned long      turn_delay_;
+    BotPool*           bot_pool_;
+    unsigned int       cpu_budget_;
+    unsigned int       turn_time_;
+    unsigned int       time_bank_;
+    float              adjudication_ratio_;
+    unsigned int       adjudication_turns_;
+    bool               concurrent_bots_;
+    bool               publish_snapshots_;
+    QString            replay_file_name_;
+    QString            profile_file_name_;
+
+    // Battle map, owned by each battle
+    team_planets::Map map_;
+    // The planets part of the bots input, shared by the bots asked together: every planet, or only the planets
+    // changed since the state last sent to them for the bots using the delta protocol, as text or binary records
+    std::string                             planets_inputs_[NumPlanetsInputs];
+    uint32_t                                planets_inputs_sizes_[NumPlanetsInputs]; // Number of planets
+    std::vector<team_planets::PlanetStore>  sent_planets_; // Base of the next delta of each player
 
-    // Battle map references
-    QMutex&             map_mutex_;
-    team_planets::Map&  map_;
+    // Players and the associated bots, each player has either a bot process or a plugin (the other is null)
+    players_list              players_;
+    std::vector<BotProcess*>  bots_;
+    std::vector<BotPlugin*>   plugins_;
+    // Bots of the dead players terminated during the battle and when they are killed if they are still running
+    std::vector<std::pair<team_planets::player_id, BotProcess::time_point>> terminated_bots_;
 
-    // Players and the associated bots
-    QMutex                  players_mutex_;
-    players_list            players_;
-    std::vector<QProcess*>  bots_;
+    // Replay recording, the events of the current turn are handed to the writer at the end of the turn
+    std::unique_ptr<ReplayWriter>     replay_writer_;
+    std::string                       replay_events_;
+    team_planets::PlanetStore         replay_planets_;
 
     // Misc statistics
     bool          battle_in_progress_;
     unsigned int  current_turn_;
     unsigned int  winner_;
+    TurnProfiler  profiler_;
+
+    // Early adjudication, the team currently dominating the battle and since how many turns
+    unsigned int  dominating_team_;
+    unsigned int  domination_turns_;
+    bool          adjudicated_;
+
+    // Published state, replaced atomically by the battle thread and read by the user interface
+    std::shared_ptr<const BattleSnapshot> snapshot_;
   };
 }
 
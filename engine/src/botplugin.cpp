@@ -0,0 +1,100 @@
+// botplugin.cpp - BotPlugin class implementation
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include <dlfcn.h>
+#include <time.h>
+#include "logger.hpp"
+#include "botplugin.hpp"
+
+using namespace std;
+using namespace team_planets_engine;
+
+// CPU time used by the calling thread, the plugins run in the battle thread
+static chrono::microseconds thread_cpu_time() {
+  timespec time;
+  if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) return chrono::microseconds::zero();
+  return chrono::duration_cast<chrono::microseconds>(chrono::seconds(time.tv_sec) + chrono::nanoseconds(time.tv_nsec));
+}
+
+BotPlugin::BotPlugin():
+  library_(nullptr), bot_(nullptr), turn_(nullptr), reset_(nullptr), free_(nullptr),
+  cpu_time_(chrono::microseconds::zero()) {
+}
+
+BotPlugin::~BotPlugin() {
+  if(bot_) free_(bot_);
+  if(library_) dlclose(library_);
+}
+
+bool BotPlugin::is_plugin(const string& file_name) {
+  static const string extension(".so");
+  return file_name.size() > extension.size()
+         && file_name.compare(file_name.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+bool BotPlugin::load(const string& file_name) {
+  // Each bot have its own symbols, the plugins of different bots may use the same names
+  library_ = dlopen(file_name.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if(!library_) {
+    ENGINE_LOG(Warning, "plugin") << "Unable to load " << file_name << ": " << dlerror();
+    return false;
+  }
+
+  teamplanets_bot_init_function init =
+      reinterpret_cast<teamplanets_bot_init_function>(dlsym(library_, "teamplanets_bot_init"));
+  turn_ = reinterpret_cast<teamplanets_bot_turn_function>(dlsym(library_, "teamplanets_bot_turn"));
+  reset_ = reinterpret_cast<teamplanets_bot_reset_function>(dlsym(library_, "teamplanets_bot_reset"));
+  free_ = reinterpret_cast<teamplanets_bot_free_function>(dlsym(library_, "teamplanets_bot_free"));
+  if(!init || !turn_ || !reset_ || !free_) {
+    ENGINE_LOG(Warning, "plugin") << file_name << " is not a bot plugin, the entry points are missing.";
+    return false;
+  }
+
+  const chrono::microseconds start_cpu_time = thread_cpu_time();
+  bot_ = init();
+  cpu_time_ += thread_cpu_time() - start_cpu_time;
+  return bot_ != nullptr;
+}
+
+bool BotPlugin::play_turn(const teamplanets_turn_input& input, teamplanets_turn_output& output) {
+  const chrono::microseconds start_cpu_time = thread_cpu_time();
+  const int ret = turn_(bot_, &input, &output);
+  cpu_time_ += thread_cpu_time() - start_cpu_time;
+
+  return ret == 0;
+}
+
+bool BotPlugin::reset() {
+  const chrono::microseconds start_cpu_time = thread_cpu_time();
+  const int ret = reset_(bot_);
+  cpu_time_ += thread_cpu_time() - start_cpu_time;
+
+  return ret == 0;
+}
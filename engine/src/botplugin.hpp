@@ -0,0 +1,74 @@
+// botplugin.hpp - BotPlugin class definition
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#ifndef _TEAMPLANETS_TEAMPLANETSENGINE_BOTPLUGIN_HPP_
+#define _TEAMPLANETS_TEAMPLANETSENGINE_BOTPLUGIN_HPP_
+
+#include <chrono>
+#include <string>
+#include "plugin.hpp"
+
+namespace team_planets_engine {
+  // A bot shared object loaded in the engine process (see plugin.hpp in libteamplanets) and called directly
+  // by the battle thread. Unlike a bot process, a plugin can't be interrupted: a late answer is only detected
+  // once the call returns.
+  class BotPlugin {
+  public:
+    BotPlugin();
+    ~BotPlugin();
+
+    // The plugins are recognized by their extension
+    static bool is_plugin(const std::string& file_name);
+
+    // Loads the shared object and creates a bot instance, returns false on failure
+    bool load(const std::string& file_name);
+
+    // Bot entry points, false if the bot have failed
+    bool play_turn(const teamplanets_turn_input& input, teamplanets_turn_output& output);
+    bool reset();
+
+    // CPU time used by the calls to the bot since its creation
+    std::chrono::microseconds cpu_time() const { return cpu_time_; }
+
+  private:
+    BotPlugin(const BotPlugin&) = delete;
+    BotPlugin& operator=(const BotPlugin&) = delete;
+
+    void*                           library_;
+    void*                           bot_;
+    teamplanets_bot_turn_function   turn_;
+    teamplanets_bot_reset_function  reset_;
+    teamplanets_bot_free_function   free_;
+
+    std::chrono::microseconds       cpu_time_;
+  };
+}
+
+#endif
@@ -0,0 +1,81 @@
+// botpoller.cpp - BotPoller class implementation
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+#include "botpoller.hpp"
+
+using namespace std;
+using namespace team_planets;
+using namespace team_planets_engine;
+
+BotPoller::BotPoller():
+  epoll_fd_(epoll_create1(EPOLL_CLOEXEC)) {
+  if(epoll_fd_ < 0) throw runtime_error("Unable to create the bots poller.");
+}
+
+BotPoller::~BotPoller() {
+  close(epoll_fd_);
+}
+
+void BotPoller::add(const BotProcess& bot, player_id id) {
+  epoll_event event;
+  event.events = EPOLLIN | EPOLLRDHUP;
+  event.data.u32 = id;
+
+  if(epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, bot.output_fd(), &event) != 0)
+    throw runtime_error("Unable to watch the bot output.");
+}
+
+void BotPoller::remove(const BotProcess& bot) {
+  epoll_event event;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, bot.output_fd(), &event);
+}
+
+void BotPoller::wait(time_point deadline, vector<player_id>& ready_players) {
+  ready_players.clear();
+
+  epoll_event events[64];
+  int num_events;
+  do {
+    // Rounding the timeout up, to never wake up before the deadline
+    const auto remaining = deadline - chrono::steady_clock::now();
+    int timeout = 0;
+    if(remaining > chrono::steady_clock::duration::zero())
+      timeout = (int)chrono::duration_cast<chrono::milliseconds>(remaining + chrono::microseconds(999)).count();
+
+    num_events = epoll_wait(epoll_fd_, events, 64, timeout);
+  } while(num_events < 0 && errno == EINTR);
+
+  for(int i = 0; i < num_events; ++i) ready_players.push_back(events[i].data.u32);
+}
@@ -0,0 +1,63 @@
+// botpoller.hpp - BotPoller class definition
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#ifndef _TEAMPLANETS_TEAMPLANETSENGINE_BOTPOLLER_HPP_
+#define _TEAMPLANETS_TEAMPLANETSENGINE_BOTPOLLER_HPP_
+
+#include <vector>
+#include "basic_types.hpp"
+#include "botprocess.hpp"
+
+namespace team_planets_engine {
+  // Waits for the output of several bots at once (epoll based), the engine wakes up as soon as some bytes
+  // are available instead of polling each bot in turn.
+  class BotPoller {
+  public:
+    typedef BotProcess::time_point time_point;
+
+    BotPoller();
+    ~BotPoller();
+
+    void add(const BotProcess& bot, team_planets::player_id id);
+    void remove(const BotProcess& bot);
+
+    // Wait until the output of some of the bots is readable (or closed) or the deadline is reached, the list
+    // of the corresponding players is returned in ready_players.
+    void wait(time_point deadline, std::vector<team_planets::player_id>& ready_players);
+
+  private:
+    BotPoller(const BotPoller&) = delete;
+    BotPoller& operator=(const BotPoller&) = delete;
+
+    int epoll_fd_;
+  };
+}
+
+#endif
@@ -0,0 +1,89 @@
+// botpool.cpp - BotPool class implementation
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include <vector>
+#include "botpool.hpp"
+
+using namespace std;
+using namespace team_planets_engine;
+
+BotPool::~BotPool() {
+  vector<BotProcess*> bots;
+  for(auto& bot:bots_) bots.push_back(bot.second);
+
+  BotProcess::terminate_all(bots, 1000);
+  for(BotProcess* bot:bots) delete bot;
+
+  for(auto& plugin:plugins_) delete plugin.second;
+}
+
+BotProcess* BotPool::acquire(const string& command) {
+  while(true) {
+    mutex_.lock();
+    auto it = bots_.find(command);
+    if(it == bots_.end()) {
+      mutex_.unlock();
+      return nullptr;
+    }
+
+    BotProcess* bot = it->second;
+    bots_.erase(it);
+    mutex_.unlock();
+
+    // The bot may have died while waiting in the pool
+    if(bot->is_running()) return bot;
+    delete bot;
+  }
+}
+
+void BotPool::release(const string& command, BotProcess* bot) {
+  mutex_.lock();
+  bots_.insert(make_pair(command, bot));
+  mutex_.unlock();
+}
+
+BotPlugin* BotPool::acquire_plugin(const string& file_name) {
+  mutex_.lock();
+  auto it = plugins_.find(file_name);
+  BotPlugin* bot = nullptr;
+  if(it != plugins_.end()) {
+    bot = it->second;
+    plugins_.erase(it);
+  }
+  mutex_.unlock();
+
+  return bot;
+}
+
+void BotPool::release(const string& file_name, BotPlugin* bot) {
+  mutex_.lock();
+  plugins_.insert(make_pair(file_name, bot));
+  mutex_.unlock();
+}
@@ -0,0 +1,68 @@
+// botpool.hpp - BotPool class definition
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#ifndef _TEAMPLANETS_TEAMPLANETSENGINE_BOTPOOL_HPP_
+#define _TEAMPLANETS_TEAMPLANETSENGINE_BOTPOOL_HPP_
+
+#include <QMutex>
+#include <map>
+#include <string>
+#include "botprocess.hpp"
+#include "botplugin.hpp"
+
+namespace team_planets_engine {
+  // Warm bot processes shared by consecutive battles. A battle gives a bot back to the pool once the bot have
+  // acknowledged the reset handshake, the next battle using the same bot command gets it instead of starting
+  // a new process. The plugins are pooled the same way once reset. The pool may be used by several battle threads
+  // at once.
+  class BotPool {
+  public:
+    BotPool() {}
+    ~BotPool();
+
+    // Returns a warm process running the given command or nullptr, the caller then owns the process
+    BotProcess* acquire(const std::string& command);
+    void release(const std::string& command, BotProcess* bot);
+
+    // Returns a reset instance of the given plugin or nullptr, the caller then owns the plugin
+    BotPlugin* acquire_plugin(const std::string& file_name);
+    void release(const std::string& file_name, BotPlugin* bot);
+
+  private:
+    BotPool(const BotPool&) = delete;
+    BotPool& operator=(const BotPool&) = delete;
+
+    QMutex                                    mutex_;
+    std::multimap<std::string, BotProcess*>   bots_;
+    std::multimap<std::string, BotPlugin*>    plugins_;
+  };
+}
+
+#endif
@@ -0,0 +1,365 @@
+// botprocess.cpp - BotProcess class implementation
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "botprocess.hpp"
+
+using namespace std;
+using namespace team_planets_engine;
+
+// Split a command line on blanks, double quotes group blank separated words
+static vector<string> split_command(const string& command) {
+  vector<string> args;
+  string current_arg;
+  bool in_quotes = false, in_arg = false;
+
+  for(char c:command) {
+    if(c == '"') {
+      in_quotes = !in_quotes;
+      in_arg = true;
+    } else if(!in_quotes && (c == ' ' || c == '\t')) {
+      if(in_arg) args.push_back(current_arg);
+      current_arg.clear();
+      in_arg = false;
+    } else {
+      current_arg += c;
+      in_arg = true;
+    }
+  }
+  if(in_arg) args.push_back(current_arg);
+
+  return args;
+}
+
+// Milliseconds remaining before a deadline, rounded up
+static int remaining_msecs(BotProcess::time_point deadline) {
+  const auto remaining = deadline - chrono::steady_clock::now();
+  if(remaining <= chrono::steady_clock::duration::zero()) return 0;
+  return (int)chrono::duration_cast<chrono::milliseconds>(remaining + chrono::microseconds(999)).count();
+}
+
+// Descriptor readable once the process has exited (Linux 5.3), -1 if the kernel doesn't support it
+static int open_pidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+  return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+  (void)pid;
+  return -1;
+#endif
+}
+
+BotProcess::BotProcess():
+  pid_(-1), input_fd_(-1), output_fd_(-1), exec_fd_(-1) {
+}
+
+BotProcess::~BotProcess() {
+  if(pid_ > 0) {
+    ::kill(pid_, SIGKILL);
+    waitpid(pid_, nullptr, 0);
+  }
+  close_pipes_();
+}
+
+bool BotProcess::start(const string& command) {
+  return launch(command) && wait_for_started();
+}
+
+bool BotProcess::launch(const string& command) {
+  // A bot dying while the engine writes to it must not kill the engine
+  static const bool sigpipe_ignored = (signal(SIGPIPE, SIG_IGN) != SIG_ERR);
+  (void)sigpipe_ignored;
+
+  vector<string> args = split_command(command);
+  if(args.empty()) return false;
+
+  vector<char*> argv;
+  for(string& arg:args) argv.push_back(&arg[0]);
+  argv.push_back(nullptr);
+
+  // All the descriptors are close-on-exec, so the other bots never inherit them
+  int input_pipe[2], output_pipe[2], exec_pipe[2];
+  if(pipe2(input_pipe, O_CLOEXEC) != 0) return false;
+  if(pipe2(output_pipe, O_CLOEXEC) != 0) {
+    ::close(input_pipe[0]); ::close(input_pipe[1]);
+    return false;
+  }
+  if(pipe2(exec_pipe, O_CLOEXEC) != 0) {
+    ::close(input_pipe[0]); ::close(input_pipe[1]);
+    ::close(output_pipe[0]); ::close(output_pipe[1]);
+    return false;
+  }
+
+  const int null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+
+  pid_ = fork();
+  if(pid_ == 0) {
+    // Child process, only async-signal-safe functions from here
+    dup2(input_pipe[0], STDIN_FILENO);
+    dup2(output_pipe[1], STDOUT_FILENO);
+    if(null_fd >= 0) dup2(null_fd, STDERR_FILENO);
+    execvp(argv[0], argv.data());
+
+    // The exec have failed, reporting it to the engine
+    const int error = errno;
+    ssize_t ret = ::write(exec_pipe[1], &error, sizeof(error));
+    (void)ret;
+    _exit(127);
+  }
+
+  ::close(input_pipe[0]);
+  ::close(output_pipe[1]);
+  ::close(exec_pipe[1]);
+  if(null_fd >= 0) ::close(null_fd);
+
+  if(pid_ < 0) {
+    ::close(input_pipe[1]);
+    ::close(output_pipe[0]);
+    ::close(exec_pipe[0]);
+    return false;
+  }
+
+  input_fd_ = input_pipe[1];
+  output_fd_ = output_pipe[0];
+  exec_fd_ = exec_pipe[0];
+  fcntl(input_fd_, F_SETFL, fcntl(input_fd_, F_GETFL) | O_NONBLOCK);
+  fcntl(output_fd_, F_SETFL, fcntl(output_fd_, F_GETFL) | O_NONBLOCK);
+
+  return true;
+}
+
+bool BotProcess::wait_for_started() {
+  if(pid_ <= 0) return false;
+  if(exec_fd_ < 0) return true;
+
+  // The exec pipe is closed without any data by a successful exec
+  int exec_error = 0;
+  ssize_t exec_ret;
+  do {
+    exec_ret = ::read(exec_fd_, &exec_error, sizeof(exec_error));
+  } while(exec_ret < 0 && errno == EINTR);
+  ::close(exec_fd_);
+  exec_fd_ = -1;
+
+  if(exec_ret > 0) {
+    waitpid(pid_, nullptr, 0);
+    pid_ = -1;
+    close_pipes_();
+    return false;
+  }
+
+  return true;
+}
+
+bool BotProcess::is_running() {
+  if(pid_ <= 0) return false;
+
+  if(waitpid(pid_, nullptr, WNOHANG) == pid_) {
+    pid_ = -1;
+    return false;
+  }
+
+  return true;
+}
+
+void BotProcess::terminate() {
+  if(pid_ > 0) ::kill(pid_, SIGTERM);
+}
+
+void BotProcess::kill() {
+  if(pid_ > 0) ::kill(pid_, SIGKILL);
+}
+
+void BotProcess::terminate_all(const vector<BotProcess*>& bots, int msecs) {
+  const time_point deadline = chrono::steady_clock::now() + chrono::milliseconds(msecs);
+
+  // Signalling all the bots first, then a single wait for all of them
+  for(BotProcess* bot:bots) bot->terminate();
+
+  // The exits are watched through a pidfd per bot, or else through the bot output hanging up (unless a child
+  // of the bot still holds it)
+  vector<BotProcess*> running_bots;
+  vector<pollfd>      fds;
+  vector<int>         pidfds;
+  for(BotProcess* bot:bots) {
+    if(!bot->is_running()) continue;
+
+    const int pidfd = open_pidfd(bot->pid_);
+    if(pidfd >= 0) pidfds.push_back(pidfd);
+    running_bots.push_back(bot);
+    fds.push_back({ pidfd >= 0 ? pidfd : bot->output_fd_, (short)(pidfd >= 0 ? POLLIN : 0), 0 });
+  }
+
+  while(!running_bots.empty()) {
+    int timeout = remaining_msecs(deadline);
+    if(timeout == 0) break;
+
+    // A bot output hangs up before the bot can be waited for, such bots are no longer polled (negative
+    // descriptors are skipped) but checked again shortly
+    const bool exiting = any_of(fds.begin(), fds.end(), [](const pollfd& fd) { return fd.fd < 0; });
+    if(exiting) timeout = min(timeout, 1);
+
+    const int num_events = poll(fds.data(), fds.size(), timeout);
+    if(num_events < 0 && errno != EINTR) break;
+
+    for(size_t i = 0; i < running_bots.size();) {
+      if((fds[i].revents != 0 || fds[i].fd < 0) && !running_bots[i]->is_running()) {
+        running_bots[i] = running_bots.back();
+        running_bots.pop_back();
+        fds[i] = fds.back();
+        fds.pop_back();
+      } else {
+        if(fds[i].revents != 0) fds[i].fd = -1;
+        ++i;
+      }
+    }
+  }
+
+  // Killing the bots still running after the deadline
+  for(BotProcess* bot:running_bots) bot->kill();
+  for(int pidfd:pidfds) ::close(pidfd);
+}
+
+chrono::microseconds BotProcess::cpu_time() const {
+  if(pid_ <= 0) return chrono::microseconds::zero();
+
+  // The CPU clock of the process counts all its threads with a nanosecond resolution
+  clockid_t clock;
+  timespec time;
+  if(clock_getcpuclockid(pid_, &clock) == 0 && clock_gettime(clock, &time) == 0) {
+    return chrono::duration_cast<chrono::microseconds>(chrono::seconds(time.tv_sec)
+                                                       + chrono::nanoseconds(time.tv_nsec));
+  }
+
+  // Else utime and stime are read from /proc, at the clock tick resolution (usually 10 ms)
+  char file_name[32];
+  snprintf(file_name, sizeof(file_name), "/proc/%d/stat", (int)pid_);
+  const int fd = open(file_name, O_RDONLY | O_CLOEXEC);
+  if(fd < 0) return chrono::microseconds::zero();
+
+  char stat[512];
+  const ssize_t size = ::read(fd, stat, sizeof(stat) - 1);
+  ::close(fd);
+  if(size <= 0) return chrono::microseconds::zero();
+  stat[size] = '\0';
+
+  // The fields following the command name (which may contain anything) are separated by blanks, utime and
+  // stime are the 12th and 13th of them
+  const char* fields = strrchr(stat, ')');
+  unsigned long long utime = 0, stime = 0;
+  if(!fields || sscanf(fields + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2)
+    return chrono::microseconds::zero();
+
+  static const long ticks_per_second = sysconf(_SC_CLK_TCK);
+  return chrono::microseconds((utime + stime)*1000000ULL/(unsigned long long)ticks_per_second);
+}
+
+bool BotProcess::write(const char* data, size_t size, time_point deadline) {
+  iovec buffer;
+  buffer.iov_base = const_cast<char*>(data);
+  buffer.iov_len = size;
+
+  return write(&buffer, 1, deadline);
+}
+
+bool BotProcess::write(iovec* buffers, int num_buffers, time_point deadline) {
+  if(input_fd_ < 0) return false;
+
+  while(num_buffers != 0) {
+    const ssize_t written = ::writev(input_fd_, buffers, num_buffers);
+
+    if(written >= 0) {
+      // Skipping the fully written buffers
+      size_t remaining = (size_t)written;
+      while(num_buffers != 0 && remaining >= buffers->iov_len) {
+        remaining -= buffers->iov_len;
+        ++buffers;
+        --num_buffers;
+      }
+      if(num_buffers != 0) {
+        buffers->iov_base = static_cast<char*>(buffers->iov_base) + remaining;
+        buffers->iov_len -= remaining;
+      }
+    } else if(errno == EAGAIN || errno == EWOULDBLOCK) {
+      // The bot don't read its input fast enough, waiting for some room in the pipe
+      pollfd fd;
+      fd.fd = input_fd_;
+      fd.events = POLLOUT;
+      fd.revents = 0;
+
+      const int msecs = remaining_msecs(deadline);
+      if(msecs == 0) return false;
+      if(poll(&fd, 1, msecs) < 0 && errno != EINTR) return false;
+    } else if(errno != EINTR) return false;
+  }
+
+  return true;
+}
+
+ssize_t BotProcess::read(char* data, size_t size) {
+  if(!unread_output_.empty()) {
+    const size_t num_unread = min(size, unread_output_.size());
+    memcpy(data, unread_output_.data(), num_unread);
+    unread_output_.erase(0, num_unread);
+    return (ssize_t)num_unread;
+  }
+
+  if(output_fd_ < 0) return -1;
+
+  while(true) {
+    const ssize_t num_read = ::read(output_fd_, data, size);
+
+    if(num_read > 0) return num_read;
+    else if(num_read == 0) return -1; // The bot have closed its output
+    else if(errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+    else if(errno != EINTR) return -1;
+  }
+}
+
+void BotProcess::close_pipes_() {
+  if(input_fd_ >= 0) ::close(input_fd_);
+  if(output_fd_ >= 0) ::close(output_fd_);
+  if(exec_fd_ >= 0) ::close(exec_fd_);
+  input_fd_ = -1;
+  output_fd_ = -1;
+  exec_fd_ = -1;
+}
@@ -0,0 +1,94 @@
+// botprocess.hpp - BotProcess class definition
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#ifndef _TEAMPLANETS_TEAMPLANETSENGINE_BOTPROCESS_HPP_
+#define _TEAMPLANETS_TEAMPLANETSENGINE_BOTPROCESS_HPP_
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace team_planets_engine {
+  // A bot executable running in its own process and connected to the engine through a pair of non-blocking
+  // pipes (the bot standard input and output). The bot standard error is discarded.
+  class BotProcess {
+  public:
+    typedef std::chrono::steady_clock::time_point time_point;
+
+    BotProcess();
+    ~BotProcess();
+
+    // Process management, start() is launch() followed by wait_for_started() so several bots may be launched
+    // before waiting for any of them
+    bool start(const std::string& command);
+    bool launch(const std::string& command);
+    bool wait_for_started();
+    bool is_running();
+    pid_t process_id() const { return pid_; }
+
+    void terminate();
+    void kill();
+
+    // User and system CPU time used by the bot since its start, zero if unknown
+    std::chrono::microseconds cpu_time() const;
+
+    // Terminate several bots at once, the bots still running after msecs are killed
+    static void terminate_all(const std::vector<BotProcess*>& bots, int msecs);
+
+    // Bot input/output, write returns false if the bot has closed its input, read returns the number of bytes
+    // available without blocking or -1 if the bot has closed its output
+    int output_fd() const { return output_fd_; }
+    bool write(const char* data, std::size_t size, time_point deadline);
+    bool write(const std::string& data, time_point deadline) { return write(data.data(), data.size(), deadline); }
+    bool write(iovec* buffers, int num_buffers, time_point deadline); // The buffers are consumed
+    ssize_t read(char* data, std::size_t size);
+
+    // Output read past the end of a response, it is returned first by the next reads
+    void unread(const char* data, std::size_t size) { unread_output_.insert(0, data, size); }
+    bool has_unread_output() const { return !unread_output_.empty(); }
+
+  private:
+    BotProcess(const BotProcess&) = delete;
+    BotProcess& operator=(const BotProcess&) = delete;
+
+    void close_pipes_();
+
+    pid_t pid_;
+    int   input_fd_;
+    int   output_fd_;
+    int   exec_fd_;     // Reports the exec failure until the start is confirmed
+
+    std::string unread_output_;
+  };
+}
+
+#endif
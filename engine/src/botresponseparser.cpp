@@ -0,0 +1,208 @@
+// botresponseparser.cpp - BotResponseParser class implementation
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include "botresponseparser.hpp"
+
+using namespace std;
+using namespace team_planets;
+using namespace team_planets_engine;
+
+// Larger binary frames are considered as errors
+static const size_t max_binary_frame_size = 1 << 20;
+
+static inline bool is_blank(char c) {
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline bool is_digit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+BotResponseParser::BotResponseParser():
+  binary_(false) {
+  reset();
+}
+
+void BotResponseParser::reset() {
+  state_ = ExpectTag;
+  tag_ = 0;
+  tag_length_ = 0;
+  number_ = 0;
+  num_args_ = 0;
+  num_expected_args_ = 0;
+  frame_.clear();
+  frame_size_ = 0;
+  fleets_.clear();
+  has_message_ = false;
+  message_ = 0;
+  has_extensions_ = false;
+  extensions_ = no_extensions;
+}
+
+size_t BotResponseParser::feed(const char* data, size_t size) {
+  if(binary_) return feed_binary_(data, size);
+
+  size_t i = 0;
+  while(i < size && !is_over()) {
+    const char c = data[i++];
+
+    switch(state_) {
+    case ExpectTag:
+      if(!is_blank(c)) {
+        tag_ = c;
+        tag_length_ = 1;
+        state_ = InTag;
+      }
+      break;
+
+    case InTag:
+      if(is_blank(c)) end_tag_();
+      else ++tag_length_;
+      break;
+
+    case ExpectNumber:
+      if(is_digit(c)) {
+        number_ = (uint64_t)(c - '0');
+        state_ = InNumber;
+      } else if(!is_blank(c)) state_ = Error;
+      break;
+
+    case InNumber:
+      if(is_digit(c)) {
+        number_ = number_*10 + (uint64_t)(c - '0');
+        if(number_ > numeric_limits<uint32_t>::max()) state_ = Error;
+      } else if(is_blank(c)) end_number_();
+      else state_ = Error;
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  if(is_complete()) {
+    while(i < size && is_blank(data[i])) ++i;
+  }
+
+  return i;
+}
+
+size_t BotResponseParser::feed_binary_(const char* data, size_t size) {
+  size_t consumed = 0;
+  while(consumed < size && !is_over()) {
+    // Reading the header first, then the remaining of the frame
+    const size_t expected_size = (frame_size_ != 0) ? frame_size_ : sizeof(BinaryOutputHeader);
+    const size_t chunk_size = min(size - consumed, expected_size - frame_.size());
+    frame_.append(data + consumed, chunk_size);
+    consumed += chunk_size;
+
+    if(frame_size_ == 0 && frame_.size() == sizeof(BinaryOutputHeader)) {
+      BinaryOutputHeader header;
+      memcpy(&header, frame_.data(), sizeof(header));
+
+      if(header.size > max_binary_frame_size
+         || header.size != sizeof(header) + (size_t)header.num_orders*sizeof(BinaryOrder)) {
+        state_ = Error;
+        break;
+      }
+      frame_size_ = header.size;
+    }
+
+    if(frame_size_ != 0 && frame_.size() == frame_size_) decode_binary_frame_();
+  }
+
+  return consumed;
+}
+
+void BotResponseParser::set_output(uint32_t message, const BinaryOrder* orders, size_t num_orders) {
+  has_message_ = true;
+  message_ = message;
+
+  for(size_t i = 0; i < num_orders; ++i)
+    fleets_.push_back(Fleet(neutral_player, orders[i].source, orders[i].destination, orders[i].num_ships, 0));
+
+  state_ = Complete;
+}
+
+void BotResponseParser::decode_binary_frame_() {
+  BinaryOutputHeader header;
+  memcpy(&header, frame_.data(), sizeof(header));
+
+  has_message_ = true;
+  message_ = header.message;
+
+  const char* record_data = frame_.data() + sizeof(header);
+  for(uint32_t i = 0; i < header.num_orders; ++i) {
+    BinaryOrder record;
+    memcpy(&record, record_data + i*sizeof(BinaryOrder), sizeof(record));
+    fleets_.push_back(Fleet(neutral_player, record.source, record.destination, record.num_ships, 0));
+  }
+
+  state_ = Complete;
+}
+
+void BotResponseParser::end_tag_() {
+  num_args_ = 0;
+  num_expected_args_ = 0;
+
+  if(tag_length_ == 1) {
+    if(tag_ == 'F') num_expected_args_ = 3;
+    else if(tag_ == 'M' || tag_ == 'X') num_expected_args_ = 1;
+    else if(tag_ == '.') {
+      state_ = Complete;
+      return;
+    }
+  }
+
+  // Unknown tags are skipped
+  state_ = (num_expected_args_ != 0) ? ExpectNumber : ExpectTag;
+}
+
+void BotResponseParser::end_number_() {
+  args_[num_args_++] = (uint32_t)number_;
+  if(num_args_ < num_expected_args_) {
+    state_ = ExpectNumber;
+    return;
+  }
+
+  if(tag_ == 'F') fleets_.push_back(Fleet(neutral_player, args_[0], args_[1], args_[2], 0));
+  else if(tag_ == 'M') {
+    has_message_ = true;
+    message_ = args_[0];
+  } else {
+    has_extensions_ = true;
+    extensions_ = args_[0];
+  }
+
+  state_ = ExpectTag;
+}
@@ -0,0 +1,105 @@
+// botresponseparser.hpp - BotResponseParser class definition
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#ifndef _TEAMPLANETS_TEAMPLANETSENGINE_BOTRESPONSEPARSER_HPP_
+#define _TEAMPLANETS_TEAMPLANETSENGINE_BOTRESPONSEPARSER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "fleet.hpp"
+#include "protocol.hpp"
+
+namespace team_planets_engine {
+  // Incremental parser of a bot response, decodes the orders as the chunks of the bot output arrive and
+  // stops on the terminating dot. Unknown tags are ignored, as bots do with the engine input.
+  class BotResponseParser {
+  public:
+    BotResponseParser();
+
+    void reset();
+
+    // The binary protocol frames are expected instead of the text (the setting survives the resets)
+    bool is_binary() const { return binary_; }
+    void set_binary(bool binary) { binary_ = binary; }
+
+    // Parse a chunk of the bot output, returns the number of bytes consumed (the bytes following the
+    // terminating dot are left unread, except the blanks ending its line)
+    std::size_t feed(const char* data, std::size_t size);
+
+    // Output of an in-process bot, already decoded, the response is then complete
+    void set_output(uint32_t message, const team_planets::BinaryOrder* orders, std::size_t num_orders);
+
+    bool is_complete() const { return state_ == Complete; }
+    bool has_error() const { return state_ == Error; }
+    bool is_over() const { return state_ == Complete || state_ == Error; }
+
+    // Decoded orders, the fleets player is not set
+    const std::vector<team_planets::Fleet>& fleets() const { return fleets_; }
+    bool has_message() const { return has_message_; }
+    uint32_t message() const { return message_; }
+    bool has_extensions() const { return has_extensions_; }
+    team_planets::protocol_extensions extensions() const { return extensions_; }
+
+  private:
+    enum State { ExpectTag, InTag, ExpectNumber, InNumber, Complete, Error };
+
+    std::size_t feed_binary_(const char* data, std::size_t size);
+    void decode_binary_frame_();
+
+    void end_tag_();
+    void end_number_();
+
+    State         state_;
+    bool          binary_;
+
+    // Current token
+    char          tag_;
+    std::size_t   tag_length_;
+    uint64_t      number_;
+    unsigned int  num_args_;
+    unsigned int  num_expected_args_;
+    uint32_t      args_[3];
+
+    // Current binary frame
+    std::string   frame_;
+    std::size_t   frame_size_;
+
+    // Decoded orders
+    std::vector<team_planets::Fleet>  fleets_;
+    bool                              has_message_;
+    uint32_t                          message_;
+    bool                              has_extensions_;
+    team_planets::protocol_extensions extensions_;
+  };
+}
+
+#endif
@@ -0,0 +1,168 @@
+// logger.cpp - Logger class implementation
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include <cstdio>
+#include <stdexcept>
+#include "logger.hpp"
+
+using namespace std;
+using namespace team_planets_engine;
+
+// The flushing thread wakes up periodically, so the producers never have to signal it
+static const chrono::milliseconds flush_period(20);
+
+Logger& Logger::instance() {
+  static Logger logger;
+  return logger;
+}
+
+const char* Logger::level_name(Level level) {
+  static const char* const names[] = { "debug", "info", "warning", "error", "off" };
+  return names[level];
+}
+
+bool Logger::parse_level(const string& name, Level& level) {
+  for(int cur_level = Debug; cur_level <= Off; ++cur_level) {
+    if(name == level_name((Level)cur_level)) {
+      level = (Level)cur_level;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+Logger::Logger():
+  level_(Info), start_time_(chrono::steady_clock::now()), head_(new Node_()), tail_(head_.load()),
+  num_pushed_(0), num_written_(0), stopping_(false) {
+  tail_->next.store(nullptr);
+  thread_ = thread(&Logger::run_, this);
+}
+
+Logger::~Logger() {
+  stopping_.store(true, memory_order_release);
+  thread_.join();
+
+  delete tail_;
+}
+
+void Logger::set_file(const string& file_name) {
+  lock_guard<mutex> lock(output_mutex_);
+
+  file_.close();
+  file_.clear();
+  file_.open(file_name, ios::out | ios::trunc);
+  if(!file_) throw runtime_error("Unable to create log file " + file_name + ".");
+}
+
+void Logger::log(Level level, const char* component, unsigned int battle, unsigned int player, string message) {
+  if(!is_enabled(level)) return;
+
+  Node_* node = new Node_();
+  node->next.store(nullptr, memory_order_relaxed);
+  node->record.time = chrono::steady_clock::now();
+  node->record.level = level;
+  node->record.component = component;
+  node->record.battle = battle;
+  node->record.player = player;
+  node->record.message.swap(message);
+
+  // Taking the head slot first, the previous head is linked afterwards
+  Node_* previous = head_.exchange(node, memory_order_acq_rel);
+  previous->next.store(node, memory_order_release);
+  num_pushed_.fetch_add(1, memory_order_release);
+}
+
+void Logger::flush() {
+  const unsigned long num_pushed = num_pushed_.load(memory_order_acquire);
+  while(num_written_.load(memory_order_acquire) < num_pushed) this_thread::sleep_for(chrono::milliseconds(1));
+}
+
+Logger::Node_* Logger::pop_() {
+  // The record is moved to the first node, which is released by the next pop
+  Node_* next = tail_->next.load(memory_order_acquire);
+  if(!next) return nullptr;
+
+  delete tail_;
+  tail_ = next;
+  return next;
+}
+
+void Logger::write_(const Record_& record) {
+  char fields[128];
+  const double time = chrono::duration<double>(record.time - start_time_).count();
+  int size = snprintf(fields, sizeof(fields), "time=%.3f level=%s component=%s",
+                      time, level_name(record.level), record.component);
+  if(record.battle != 0) size += snprintf(fields + size, sizeof(fields) - size, " battle=%u", record.battle);
+  if(record.player != 0) size += snprintf(fields + size, sizeof(fields) - size, " player=%u", record.player);
+
+  // The message is quoted, the protocol dumps are kept on a single line
+  line_.assign(fields, (size_t)size);
+  line_ += " msg=\"";
+  size_t length = record.message.size();
+  while(length != 0 && record.message[length - 1] == '\n') --length;
+  for(size_t i = 0; i < length; ++i) {
+    const char c = record.message[i];
+    if(c == '\n') line_ += "\\n";
+    else if(c == '"' || c == '\\') {
+      line_ += '\\';
+      line_ += c;
+    } else line_ += c;
+  }
+  line_ += "\"\n";
+
+  if(file_.is_open()) file_.write(line_.data(), line_.size());
+  else fwrite(line_.data(), 1, line_.size(), stderr);
+}
+
+void Logger::run_() {
+  bool stopping = false;
+
+  while(!stopping) {
+    // Checked before the draining, so the records logged before the stop are all written
+    stopping = stopping_.load(memory_order_acquire);
+
+    unsigned long num_written = 0;
+    output_mutex_.lock();
+    while(Node_* node = pop_()) {
+      write_(node->record);
+      node->record.message.clear();
+      ++num_written;
+    }
+    if(num_written != 0) {
+      if(file_.is_open()) file_.flush();
+      else fflush(stderr);
+    }
+    output_mutex_.unlock();
+    num_written_.fetch_add(num_written, memory_order_release);
+
+    if(!stopping) this_thread::sleep_for(flush_period);
+  }
+}
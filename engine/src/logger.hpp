@@ -0,0 +1,149 @@
+// logger.hpp - Logger class definition
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#ifndef _TEAMPLANETS_TEAMPLANETSENGINE_LOGGER_HPP_
+#define _TEAMPLANETS_TEAMPLANETSENGINE_LOGGER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace team_planets_engine {
+  // Leveled engine logger. The records are pushed by any thread on a lock-free queue and formatted by a
+  // background thread, one key=value line per record, so logging never blocks a battle. The records under
+  // the current level are dropped by ENGINE_LOG before their message is even built.
+  class Logger {
+  public:
+    enum Level {
+      Debug,      // Full bots protocol dumps
+      Info,
+      Warning,    // Misbehaving bots
+      Error,
+      Off
+    };
+
+    // The process wide logger
+    static Logger& instance();
+
+    static const char* level_name(Level level);
+    static bool parse_level(const std::string& name, Level& level);
+
+    Level level() const { return (Level)level_.load(std::memory_order_relaxed); }
+    void set_level(Level level) { level_.store(level, std::memory_order_relaxed); }
+    bool is_enabled(Level level) const { return level != Off && level >= this->level(); }
+
+    // Writes the records to a file instead of the standard error output
+    void set_file(const std::string& file_name);
+
+    // Any thread, the battle and player are optional (0 if none)
+    void log(Level level, const char* component, unsigned int battle, unsigned int player, std::string message);
+
+    // Waits until all the records logged so far are written
+    void flush();
+
+  private:
+    struct Record_ {
+      std::chrono::steady_clock::time_point time;
+      Level         level;
+      const char*   component;
+      unsigned int  battle;
+      unsigned int  player;
+      std::string   message;
+    };
+
+    // Node of the multiple producers single consumer queue, the consumer owns the first node
+    struct Node_ {
+      std::atomic<Node_*> next;
+      Record_             record;
+    };
+
+    Logger();
+    ~Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    Node_* pop_();
+    void write_(const Record_& record);
+    void run_();
+
+    std::atomic<int>                            level_;
+    const std::chrono::steady_clock::time_point start_time_;
+
+    // Queue, pushed to the head and popped from the tail
+    std::atomic<Node_*>           head_;
+    Node_*                        tail_;
+    std::atomic<unsigned long>    num_pushed_;
+    std::atomic<unsigned long>    num_written_;
+
+    // Flushing thread
+    std::mutex                    output_mutex_;
+    std::ofstream                 file_;
+    std::string                   line_;
+    std::atomic<bool>             stopping_;
+    std::thread                   thread_;
+  };
+
+  // A record built by ENGINE_LOG, logged once the statement is over
+  class LogRecord {
+  public:
+    LogRecord(Logger::Level level, const char* component, unsigned int battle = 0, unsigned int player = 0):
+      level_(level), component_(component), battle_(battle), player_(player) {}
+    ~LogRecord() { Logger::instance().log(level_, component_, battle_, player_, message_.str()); }
+
+    std::ostream& stream() { return message_; }
+
+  private:
+    LogRecord(const LogRecord&) = delete;
+    LogRecord& operator=(const LogRecord&) = delete;
+
+    const Logger::Level level_;
+    const char* const   component_;
+    const unsigned int  battle_;
+    const unsigned int  player_;
+    std::ostringstream  message_;
+  };
+
+  // Turns the ENGINE_LOG stream into an expression, so the macro can be used anywhere as a statement
+  struct LogVoidify {
+    void operator&(std::ostream&) {}
+  };
+}
+
+// Usage: ENGINE_LOG(Info, "battle", battle_id, player_id) << "message", the battle and player are optional
+#define ENGINE_LOG(level, ...) \
+  !team_planets_engine::Logger::instance().is_enabled(team_planets_engine::Logger::level) ? (void)0 : \
+  team_planets_engine::LogVoidify() & team_planets_engine::LogRecord(team_planets_engine::Logger::level, \
+                                                                     __VA_ARGS__).stream()
+
+#endif
@@ -30,6 +30,7 @@
 
 #include <QtWidgets>
 #include <algorithm>
+#include <exception>
 #include "startbattledialog.hpp"
 #include "mainwindow.hpp"
 
@@ -65,6 +66,12 @@ void MainWindow::startBattleActionTriggered_() {
     dialog->set_team1_num_players(battle_thread_->team1_num_players());
     dialog->set_team2_bot_file_name(battle_thread_->team2_bot_file_name());
     dialog->set_team2_num_players(battle_thread_->team2_num_players());
+  } else if(replay_) {
+    dialog->set_map_file_name(replay_->map_file_name());
+    dialog->set_team1_bot_file_name(replay_->team1_bot_file_name());
+    dialog->set_team1_num_players(replay_->team1_num_players());
+    dialog->set_team2_bot_file_name(replay_->team2_bot_file_name());
+    dialog->set_team2_num_players(replay_->team2_num_players());
   }
 
   if(dialog->exec())
@@ -73,6 +80,12 @@ void MainWindow::startBattleActionTriggered_() {
                     dialog->team2_bot_file_name(), dialog->team2_num_players());
 }
 
+void MainWindow::openReplayActionTriggered_() {
+  const QString replay_file_name = QFileDialog::getOpenFileName(this, tr("Open replay"), QString(),
+                                                                tr("Replays (*.replay);;All files (*)"));
+  if(!replay_file_name.isEmpty()) openReplay_(replay_file_name);
+}
+
 void MainWindow::quitActionTriggered_() {
   stopBattle_();
   qApp->quit();
@@ -112,23 +125,29 @@ void MainWindow::aboutActionTriggered_() {
 }
 
 void MainWindow::battle_thread_map_updated_() {
+  // An update queued by a battle destroyed in the meantime
+  if(!battle_thread_) return;
+
   update_teams_tables_();
   ui_.battleMap->update();
 
-  if(battle_thread_->battle_in_progress())
-    statusBar()->showMessage(tr("Turn: %1").arg(battle_thread_->current_turn()));
+  const std::shared_ptr<const BattleSnapshot> snapshot = battle_thread_->snapshot();
+  if(!snapshot) return;
+
+  if(snapshot->battle_in_progress)
+    statusBar()->showMessage(tr("Turn: %1").arg(snapshot->current_turn));
   else {
-    switch(battle_thread_->winner()) {
+    switch(snapshot->winner) {
     case 1:
-      statusBar()->showMessage(tr("Battle is over in %1 turns. Team 1 wins!").arg(battle_thread_->current_turn()));
+      statusBar()->showMessage(tr("Battle is over in %1 turns. Team 1 wins!").arg(snapshot->current_turn));
       break;
 
     case 2:
-      statusBar()->showMessage(tr("Battle is over in %1 turns. Team 2 wins!").arg(battle_thread_->current_turn()));
+      statusBar()->showMessage(tr("Battle is over in %1 turns. Team 2 wins!").arg(snapshot->current_turn));
       break;
 
     default:
-      statusBar()->showMessage(tr("Battle is over in %1 turns. No winner!").arg(battle_thread_->current_turn()));
+      statusBar()->showMessage(tr("Battle is over in %1 turns. No winner!").arg(snapshot->current_turn));
     }
 
   }
@@ -138,24 +157,39 @@ void MainWindow::battle_thread_error_occured(const QString& msg) {
   QMessageBox::critical(this, tr("Battle error"), msg);
 }
 
+void MainWindow::timelineSliderValueChanged_(int turn) {
+  if(!replay_) return;
+
+  replay_->seek((unsigned int)turn);
+  update_teams_tables_();
+  update_replay_status_();
+  ui_.battleMap->update();
+}
+
 void MainWindow::buildInterface_() {
   // Creating the user interface
   ui_.setupUi(this);
-  ui_.battleMap->set_map(map_mutex_, map_);
 
   // Moving main splitter handle to a more comfortable position
   ui_.mainSplitter->setStretchFactor(0, 2);
+
+  // The timeline is only used by the replays
+  ui_.timelineSlider->hide();
 }
 
 void MainWindow::connectSlots_() {
   connect(ui_.startBattleAction, &QAction::triggered, this, &MainWindow::startBattleActionTriggered_);
+  connect(ui_.openReplayAction, &QAction::triggered, this, &MainWindow::openReplayActionTriggered_);
   connect(ui_.quitAction, &QAction::triggered, this, &MainWindow::quitActionTriggered_);
 
   connect(ui_.aboutAction, &QAction::triggered, this, &MainWindow::aboutActionTriggered_);
+
+  connect(ui_.timelineSlider, &QSlider::valueChanged, this, &MainWindow::timelineSliderValueChanged_);
 }
 
 void MainWindow::parseCommandLine_() {
-  if(argc_ > 5) {
+  if(argc_ == 3 && QString(argv_[1]) == "--replay") openReplay_(argv_[2]);
+  else if(argc_ > 5) {
     bool ok1 = false, ok2 = false;
     const unsigned int team1_num_players = QString(argv_[3]).toUInt(&ok1);
     const unsigned int team2_num_players = QString(argv_[5]).toUInt(&ok2);
@@ -167,18 +201,14 @@ void MainWindow::parseCommandLine_() {
 void MainWindow::startNewBattle_(QString map_file_name,
                                  QString team1_bot_file_name, unsigned int team1_num_players,
                                  QString team2_bot_file_name, unsigned int team2_num_players) {
-  // Get rid of the current battle thread
-  if(battle_thread_) {
-    battle_thread_->stop();
-    battle_thread_->wait();
-    battle_thread_->deleteLater();
-    battle_thread_ = nullptr;
-  }
+  // Get rid of the current battle thread or replay
+  destroyBattle_();
+  closeReplay_();
 
   // Starting the new battle
   battle_thread_ = new BattleThread(map_file_name, team1_bot_file_name, team1_num_players,
-                                    team2_bot_file_name, team2_num_players, map_mutex_, map_,
-                                    this);
+                                    team2_bot_file_name, team2_num_players, this);
+  battle_thread_->set_publish_snapshots(true);
   connect(battle_thread_, &BattleThread::map_updated, this, &MainWindow::battle_thread_map_updated_);
   connect(battle_thread_, &BattleThread::error_occured, this, &MainWindow::battle_thread_error_occured);
 
@@ -193,67 +223,153 @@ void MainWindow::stopBattle_() {
   }
 }
 
+void MainWindow::destroyBattle_() {
+  if(battle_thread_) {
+    battle_thread_->stop();
+    battle_thread_->wait();
+    disconnect(battle_thread_, nullptr, this, nullptr);
+    battle_thread_->deleteLater();
+    battle_thread_ = nullptr;
+    ui_.battleMap->set_battle_thread(nullptr);
+  }
+}
+
+void MainWindow::openReplay_(QString replay_file_name) {
+  std::unique_ptr<Replay> replay(new Replay);
+  try {
+    replay->load(replay_file_name.toStdString());
+  } catch(const std::exception& e) {
+    QMessageBox::critical(this, tr("Replay error"), QString(e.what()));
+    return;
+  }
+
+  // The replay replaces the current battle, starting from the beginning
+  destroyBattle_();
+  replay_ = std::move(replay);
+  replay_->seek(0);
+  ui_.battleMap->set_replay(replay_.get());
+
+  ui_.timelineSlider->blockSignals(true);
+  ui_.timelineSlider->setRange(0, (int)replay_->num_turns());
+  ui_.timelineSlider->setValue(0);
+  ui_.timelineSlider->blockSignals(false);
+  ui_.timelineSlider->show();
+
+  update_teams_tables_();
+  update_replay_status_();
+  ui_.battleMap->update();
+}
+
+void MainWindow::closeReplay_() {
+  if(replay_) {
+    ui_.battleMap->set_replay(nullptr);
+    ui_.timelineSlider->hide();
+    replay_.reset();
+  }
+}
+
+void MainWindow::update_replay_status_() {
+  QString status = tr("Replay turn: %1 of %2.").arg(replay_->current_turn()).arg(replay_->num_turns());
+
+  if(!replay_->is_complete()) status += tr(" The battle was not recorded until the end.");
+  else if(replay_->current_turn() == replay_->num_turns()) {
+    switch(replay_->winner()) {
+    case 1: status += tr(" Team 1 wins!"); break;
+    case 2: status += tr(" Team 2 wins!"); break;
+    default: status += tr(" No winner!");
+    }
+  }
+
+  statusBar()->showMessage(status);
+}
+
 void MainWindow::update_teams_tables_() {
+  if(replay_) {
+    fill_teams_tables_(replay_->team1_num_players(), replay_->team2_num_players(),
+                       replay_->players_begin(), replay_->players_end());
+  } else if(battle_thread_) {
+    const std::shared_ptr<const BattleSnapshot> snapshot = battle_thread_->snapshot();
+    if(snapshot) {
+      fill_teams_tables_(battle_thread_->team1_num_players(), battle_thread_->team2_num_players(),
+                         snapshot->players.begin(), snapshot->players.end());
+    }
+  }
+}
+
+void MainWindow::fill_teams_tables_(unsigned int team1_num_players, unsigned int team2_num_players,
+                                    BattleThread::player_const_iterator players_begin,
+                                    BattleThread::player_const_iterator players_end) {
   QStringList header;
-  header << "ID" << "C" << "S" << "Planets" << "Ships" << "Ping (ms)";
+  header << "ID" << "C" << "S" << "Planets" << "Ships" << "Ping (ms)" << "p50" << "p95" << "p99" << "Max"
+         << "CPU (ms)";
+
+  // Updating the first team table
+  ui_.team1Table->clear();
+  ui_.team1Table->setColumnCount(11);
+  ui_.team1Table->setRowCount(team1_num_players);
+  ui_.team1Table->setHorizontalHeaderLabels(header);
+  ui_.team1Table->verticalHeader()->hide();
+
+  // Updating the second team table
+  ui_.team2Table->clear();
+  ui_.team2Table->setColumnCount(11);
+  ui_.team2Table->setRowCount(team2_num_players);
+  ui_.team2Table->setHorizontalHeaderLabels(header);
+  ui_.team2Table->verticalHeader()->hide();
+
+  // Filling in the content
+  int team1_row = 0, team2_row = 0;
+
+  std::for_each(players_begin, players_end, [this,&team1_row,&team2_row](const Player& player) {
+    QTableWidgetItem* id_item = new QTableWidgetItem(QString("%1").arg(player.id()));
+    QTableWidgetItem* color_item = new QTableWidgetItem;
+    color_item->setBackgroundColor(player.color());
+
+    QTableWidgetItem* status_item = nullptr;
+    switch(player.status()) {
+    case Player::Alive: status_item =  new QTableWidgetItem(tr("A")); break;
+    case Player::Dead: status_item =  new QTableWidgetItem(tr("D")); break;
+    case Player::Failed: status_item =  new QTableWidgetItem(tr("F")); break;
+    }
 
-  if(battle_thread_) {
-    // Updating the first team table
-    ui_.team1Table->clear();
-    ui_.team1Table->setColumnCount(6);
-    ui_.team1Table->setRowCount(battle_thread_->team1_num_players());
-    ui_.team1Table->setHorizontalHeaderLabels(header);
-    ui_.team1Table->verticalHeader()->hide();
-
-    // Updating the second team table
-    ui_.team2Table->clear();
-    ui_.team2Table->setColumnCount(6);
-    ui_.team2Table->setRowCount(battle_thread_->team2_num_players());
-    ui_.team2Table->setHorizontalHeaderLabels(header);
-    ui_.team2Table->verticalHeader()->hide();
-
-    // Filling in the content
-    int team1_row = 0, team2_row = 0;
-
-    battle_thread_->lock_players();
-    std::for_each(battle_thread_->players_begin(), battle_thread_->players_end(),
-                  [this,&team1_row,&team2_row](const Player& player) {
-      QTableWidgetItem* id_item = new QTableWidgetItem(QString("%1").arg(player.id()));
-      QTableWidgetItem* color_item = new QTableWidgetItem;
-      color_item->setBackgroundColor(player.color());
-
-      QTableWidgetItem* status_item = nullptr;
-      switch(player.status()) {
-      case Player::Alive: status_item =  new QTableWidgetItem(tr("A")); break;
-      case Player::Dead: status_item =  new QTableWidgetItem(tr("D")); break;
-      case Player::Failed: status_item =  new QTableWidgetItem(tr("F")); break;
-      }
-
-      QTableWidgetItem* planets_item = new QTableWidgetItem(QString("%1").arg(player.num_planets()));
-      QTableWidgetItem* ships_item = new QTableWidgetItem(QString("%1").arg(player.num_ships()));
-      QTableWidgetItem* ping_item = new QTableWidgetItem(QString("%1").arg(player.ping()));
-
-      if(player.team() == 1) {
-        ui_.team1Table->setItem(team1_row, 0, id_item);
-        ui_.team1Table->setItem(team1_row, 1, color_item);
-        ui_.team1Table->setItem(team1_row, 2, status_item);
-        ui_.team1Table->setItem(team1_row, 3, planets_item);
-        ui_.team1Table->setItem(team1_row, 4, ships_item);
-        ui_.team1Table->setItem(team1_row, 5, ping_item);
-        ++team1_row;
-      } else {
-        ui_.team2Table->setItem(team2_row, 0, id_item);
-        ui_.team2Table->setItem(team2_row, 1, color_item);
-        ui_.team2Table->setItem(team2_row, 2, status_item);
-        ui_.team2Table->setItem(team2_row, 3, planets_item);
-        ui_.team2Table->setItem(team2_row, 4, ships_item);
-        ui_.team2Table->setItem(team2_row, 5, ping_item);
-        ++team2_row;
-      }
-    });
-    battle_thread_->unlock_players();
-
-    ui_.team1Table->resizeColumnsToContents();
-    ui_.team2Table->resizeColumnsToContents();
-  }
+    QTableWidgetItem* planets_item = new QTableWidgetItem(QString("%1").arg(player.num_planets()));
+    QTableWidgetItem* ships_item = new QTableWidgetItem(QString("%1").arg(player.num_ships()));
+    QTableWidgetItem* ping_item = new QTableWidgetItem(QString("%1").arg(player.ping()));
+    QTableWidgetItem* p50_item = new QTableWidgetItem(QString("%1").arg(player.ping_percentile(50)));
+    QTableWidgetItem* p95_item = new QTableWidgetItem(QString("%1").arg(player.ping_percentile(95)));
+    QTableWidgetItem* p99_item = new QTableWidgetItem(QString("%1").arg(player.ping_percentile(99)));
+    QTableWidgetItem* max_item = new QTableWidgetItem(QString("%1").arg(player.max_ping()));
+    QTableWidgetItem* cpu_item = new QTableWidgetItem(QString("%1").arg(player.total_cpu_time()));
+
+    if(player.team() == 1) {
+      ui_.team1Table->setItem(team1_row, 0, id_item);
+      ui_.team1Table->setItem(team1_row, 1, color_item);
+      ui_.team1Table->setItem(team1_row, 2, status_item);
+      ui_.team1Table->setItem(team1_row, 3, planets_item);
+      ui_.team1Table->setItem(team1_row, 4, ships_item);
+      ui_.team1Table->setItem(team1_row, 5, ping_item);
+      ui_.team1Table->setItem(team1_row, 6, p50_item);
+      ui_.team1Table->setItem(team1_row, 7, p95_item);
+      ui_.team1Table->setItem(team1_row, 8, p99_item);
+      ui_.team1Table->setItem(team1_row, 9, max_item);
+      ui_.team1Table->setItem(team1_row, 10, cpu_item);
+      ++team1_row;
+    } else {
+      ui_.team2Table->setItem(team2_row, 0, id_item);
+      ui_.team2Table->setItem(team2_row, 1, color_item);
+      ui_.team2Table->setItem(team2_row, 2, status_item);
+      ui_.team2Table->setItem(team2_row, 3, planets_item);
+      ui_.team2Table->setItem(team2_row, 4, ships_item);
+      ui_.team2Table->setItem(team2_row, 5, ping_item);
+      ui_.team2Table->setItem(team2_row, 6, p50_item);
+      ui_.team2Table->setItem(team2_row, 7, p95_item);
+      ui_.team2Table->setItem(team2_row, 8, p99_item);
+      ui_.team2Table->setItem(team2_row, 9, max_item);
+      ui_.team2Table->setItem(team2_row, 10, cpu_item);
+      ++team2_row;
+    }
+  });
+
+  ui_.team1Table->resizeColumnsToContents();
+  ui_.team2Table->resizeColumnsToContents();
 }
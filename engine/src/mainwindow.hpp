@@ -33,9 +33,9 @@
 
 #include <QMainWindow>
 #include <QString>
-#include <QMutex>
+#include <memory>
 #include "battlethread.hpp"
-#include "map.hpp"
+#include "replay.hpp"
 #include "ui_mainwindow.h"
 
 namespace team_planets_engine {
@@ -51,12 +51,15 @@ namespace team_planets_engine {
 
   private slots:
     void startBattleActionTriggered_();
+    void openReplayActionTriggered_();
     void quitActionTriggered_();
     void aboutActionTriggered_();
 
     void battle_thread_map_updated_();
     void battle_thread_error_occured(const QString& msg);
 
+    void timelineSliderValueChanged_(int turn);
+
   private:
     Q_DISABLE_COPY(MainWindow)
 
@@ -68,8 +71,16 @@ namespace team_planets_engine {
                          QString team1_bot_file_name, unsigned int team1_num_players,
                          QString team2_bot_file_name, unsigned int team2_num_players);
     void stopBattle_();
+    void destroyBattle_();
+
+    void openReplay_(QString replay_file_name);
+    void closeReplay_();
+    void update_replay_status_();
 
     void update_teams_tables_();
+    void fill_teams_tables_(unsigned int team1_num_players, unsigned int team2_num_players,
+                            BattleThread::player_const_iterator players_begin,
+                            BattleThread::player_const_iterator players_end);
 
     // User interface
     Ui::MainWindow  ui_;
@@ -79,10 +90,8 @@ namespace team_planets_engine {
     const char**  argv_;
 
     // Application data
-    BattleThread*     battle_thread_;
-
-    QMutex            map_mutex_;
-    team_planets::Map map_;
+    BattleThread*           battle_thread_;
+    std::unique_ptr<Replay> replay_;
   };
 }
 
@@ -34,6 +34,7 @@
 #include <algorithm>
 #include "map.hpp"
 #include "battlethread.hpp"
+#include "replay.hpp"
 #include "mapwidget.hpp"
 
 using namespace std;
@@ -53,7 +54,7 @@ inline qreal euclidian_distance(const QPointF& p1, const QPointF& p2) {
 }
 
 MapWidget::MapWidget(QWidget* parent, Qt::WindowFlags flags):
-  QWidget(parent, flags), map_mutex_(nullptr), map_(nullptr), battle_thread_(nullptr),
+  QWidget(parent, flags), battle_thread_(nullptr), replay_(nullptr),
   background_color_(Qt::black), neutral_color_(Qt::green),
   border_margin_(2.5), planet_base_radius_(15.0), planet_radius_incr_per_ship_prod_(1.0),
   fleet_size_(5.0) {
@@ -66,34 +67,41 @@ void MapWidget::paintEvent(QPaintEvent* event) {
   // Filling the background
   painter.fillRect(0, 0, width(), height(), QBrush(background_color_));
 
-  // Drawing the map
-  map_mutex_->lock();
-  compute_map_bounding_box_();
+  // Drawing the map, the replay is only used by the user interface thread and the battle is drawn from its
+  // last snapshot, so no locking is needed
+  if(!battle_thread_ && !replay_) return;
+
+  if(!replay_) {
+    snapshot_ = battle_thread_->snapshot();
+    if(!snapshot_) return;
+  }
+  const Map& map = replay_ ? replay_->map() : snapshot_->map;
+  compute_map_bounding_box_(map);
 
   // Drawing the planets
-  for_each(map_->planets_begin(), map_->planets_end(), [this, &painter](const Planet& planet) {
+  for_each(map.planets_begin(), map.planets_end(), [this, &painter](ConstPlanetView planet) {
     draw_planet_(painter, planet);
   });
 
   // Drawing the fleets
-  for_each(map_->fleets_begin(), map_->fleets_end(), [this, &painter](const Fleet& fleet) {
-    draw_fleet_(painter, fleet);
+  for_each(map.fleets_begin(), map.fleets_end(), [this, &painter, &map](const Fleet& fleet) {
+    draw_fleet_(painter, map, fleet);
   });
 
-  map_mutex_->unlock();
+  snapshot_.reset();
 }
 
-void MapWidget::compute_map_bounding_box_() {
+void MapWidget::compute_map_bounding_box_(const Map& map) {
   // Computing min-max coordinates of the planets
   float min_x = 0.0f, min_y = 0.0f, max_x = 0.0f, max_y = 0.0f;
-  if(map_->num_planets() != 0) {
-    min_x = map_->planets_begin()->location().x();
-    min_y = map_->planets_begin()->location().y();
-    max_x = map_->planets_begin()->location().x();
-    max_y = map_->planets_begin()->location().y();
+  if(map.num_planets() != 0) {
+    min_x = map.planets_begin()->location().x();
+    min_y = map.planets_begin()->location().y();
+    max_x = map.planets_begin()->location().x();
+    max_y = map.planets_begin()->location().y();
   }
 
-  for_each(map_->planets_begin(), map_->planets_end(), [&min_x, &min_y, &max_x, &max_y](const Planet& planet) {
+  for_each(map.planets_begin(), map.planets_end(), [&min_x, &min_y, &max_x, &max_y](ConstPlanetView planet) {
     if(min_x > planet.location().x()) min_x = planet.location().x();
     if(min_y > planet.location().y()) min_y = planet.location().y();
     if(max_x < planet.location().x()) max_x = planet.location().x();
@@ -107,7 +115,7 @@ void MapWidget::compute_map_bounding_box_() {
   map_bounding_box_ = QRectF(QPointF((qreal)min_x, (qreal)min_y), QPointF((qreal)max_x, (qreal)max_y));
 }
 
-QPointF MapWidget::compute_planet_location_in_widget_coordinates_(const Planet& planet) {
+QPointF MapWidget::compute_planet_location_in_widget_coordinates_(const ConstPlanetView& planet) {
   const float x = (planet.location().x() - (float)map_bounding_box_.x())
       *((float)width()/(float)map_bounding_box_.width());
   const float y = (planet.location().y() - (float)map_bounding_box_.y())
@@ -115,14 +123,19 @@ QPointF MapWidget::compute_planet_location_in_widget_coordinates_(const Planet&
   return QPointF((qreal)x, (qreal)y);
 }
 
-void MapWidget::draw_planet_(QPainter& painter, const Planet& planet) {
+QColor MapWidget::player_color_(player_id id) const {
+  if(id == neutral_player) return neutral_color_;
+  if(replay_) return replay_->player(id).color();
+  if(snapshot_ && id <= snapshot_->players.size()) return snapshot_->players[id - 1].color();
+  return neutral_color_;
+}
+
+void MapWidget::draw_planet_(QPainter& painter, const ConstPlanetView& planet) {
   const QPointF planet_pos = compute_planet_location_in_widget_coordinates_(planet);
   const qreal planet_radius = planet_base_radius_ + (qreal)planet.ship_increase()*planet_radius_incr_per_ship_prod_;
 
   // Selecting planet color
-  QColor planet_color = neutral_color_;
-  if(battle_thread_ && planet.current_owner() != neutral_player)
-    planet_color = battle_thread_->player(planet.current_owner()).color();
+  const QColor planet_color = player_color_(planet.current_owner());
 
   // Drawing planet
   painter.setPen(planet_color);
@@ -135,22 +148,22 @@ void MapWidget::draw_planet_(QPainter& painter, const Planet& planet) {
                    tr("%1").arg(planet.current_num_ships()));
 }
 
-void MapWidget::draw_fleet_(QPainter& painter, const Fleet& fleet) {
-  const QPointF source_pos = compute_planet_location_in_widget_coordinates_(map_->planet(fleet.source()));
-  const QPointF destination_pos = compute_planet_location_in_widget_coordinates_(map_->planet(fleet.destination()));
+void MapWidget::draw_fleet_(QPainter& painter, const Map& map, const Fleet& fleet) {
+  const QPointF source_pos = compute_planet_location_in_widget_coordinates_(map.planet(fleet.source()));
+  const QPointF destination_pos = compute_planet_location_in_widget_coordinates_(map.planet(fleet.destination()));
 
   // Computing fleet position
   const qreal traj_angle = rad2deg(std::atan2(destination_pos.y() - source_pos.y(),
                                               destination_pos.x() - source_pos.x()));
 
-  const unsigned int travel_time = map_->planet(fleet.destination())
-      .compute_travel_distance(map_->planet(fleet.source()));
-  const qreal traj_adv = (qreal)(travel_time - fleet.remaining_turns())
-      *euclidian_distance(source_pos, destination_pos)/(qreal)travel_time;
+  // The fleets sent at a zero distance, or having more remaining turns than their travel time, stay at their source
+  const unsigned int travel_time = map.travel_distance(fleet.source(), fleet.destination());
+  const unsigned int elapsed_time = (fleet.remaining_turns() < travel_time) ? travel_time - fleet.remaining_turns() : 0;
+  const qreal traj_adv = (travel_time != 0)
+      ? (qreal)elapsed_time*euclidian_distance(source_pos, destination_pos)/(qreal)travel_time : 0.0;
 
   // Selecting fleet color
-  QColor fleet_color = neutral_color_;
-  if(battle_thread_) fleet_color = battle_thread_->player(fleet.player()).color();
+  const QColor fleet_color = player_color_(fleet.player());
 
   painter.save();
   painter.translate(source_pos);
@@ -33,12 +33,15 @@
 
 #include <QWidget>
 #include <QColor>
+#include <memory>
+#include "basic_types.hpp"
 
-class QMutex;
 namespace team_planets { class Map; class Planet; class Fleet; }
 
 namespace team_planets_engine {
   class BattleThread;
+  struct BattleSnapshot;
+  class Replay;
 
   class MapWidget: public QWidget {
     Q_OBJECT
@@ -54,11 +57,9 @@ namespace team_planets_engine {
   public:
     explicit MapWidget(QWidget* parent = nullptr, Qt::WindowFlags flags = 0);
 
-    void set_map(QMutex& map_mutex, team_planets::Map& map) {
-      map_mutex_ = &map_mutex;
-      map_ = &map;
-    }
+    // The displayed map comes from the replay if any, else from the battle thread
     void set_battle_thread(BattleThread* thread) { battle_thread_ = thread; }
+    void set_replay(const Replay* replay) { replay_ = replay; }
 
     // Different map colors accessors
     QColor background_color() const { return background_color_; }
@@ -84,16 +85,19 @@ namespace team_planets_engine {
     Q_DISABLE_COPY(MapWidget)
 
     // Internal drawing routines
-    void compute_map_bounding_box_();
-    QPointF compute_planet_location_in_widget_coordinates_(const team_planets::Planet& planet);
+    void compute_map_bounding_box_(const team_planets::Map& map);
+    QPointF compute_planet_location_in_widget_coordinates_(const team_planets::ConstPlanetView& planet);
+    QColor player_color_(team_planets::player_id id) const;
 
-    void draw_planet_(QPainter& painter, const team_planets::Planet& planet);
-    void draw_fleet_(QPainter& painter, const team_planets::Fleet& fleet);
+    void draw_planet_(QPainter& painter, const team_planets::ConstPlanetView& planet);
+    void draw_fleet_(QPainter& painter, const team_planets::Map& map, const team_planets::Fleet& fleet);
 
-    // The battle map and thread
-    QMutex*             map_mutex_;
-    team_planets::Map*  map_;
+    // The battle thread or the replay owning the displayed map
     BattleThread*       battle_thread_;
+    const Replay*       replay_;
+
+    // State of the battle being drawn, taken from the battle thread at each repaint
+    std::shared_ptr<const BattleSnapshot> snapshot_;
 
     // Different map colors and properties
     QColor  background_color_;
@@ -28,6 +28,7 @@
 // OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
 // SUCH DAMAGE.
 
+#include <algorithm>
 #include "player.hpp"
 
 using namespace team_planets;
@@ -35,5 +36,48 @@ using namespace team_planets_engine;
 
 Player::Player(player_id id, unsigned int team, QColor color):
     id_(id), team_(team), color_(color), status_(Alive),
-    num_planets_(0), num_ships_(0), ping_(0), message_(0) {
+    num_planets_(0), num_ships_(0), ping_(0), ping_limit_(0), ping_bucket_width_(0), num_pings_(0), max_ping_(0),
+    cpu_time_(0), total_cpu_time_(0), time_bank_(0), message_(0),
+    extensions_(team_planets::no_extensions) {
+  std::fill(ping_histogram_, ping_histogram_ + num_ping_buckets, 0);
+  set_ping_limit(1000);
+}
+
+void Player::set_ping_limit(unsigned int ping_limit) {
+  ping_limit_ = ping_limit;
+
+  // The coarse buckets cover the response times up to the limit
+  const unsigned int coarse_range = (ping_limit > num_fine_ping_buckets) ? ping_limit - num_fine_ping_buckets : 0;
+  ping_bucket_width_ = std::max((coarse_range + num_coarse_ping_buckets - 1)/num_coarse_ping_buckets, 1u);
+}
+
+void Player::set_ping(unsigned int ping) {
+  ping_ = ping;
+
+  ++ping_histogram_[ping_bucket_(ping)];
+  ++num_pings_;
+  if(ping > max_ping_) max_ping_ = ping;
+}
+
+unsigned int Player::ping_percentile(unsigned int percent) const {
+  if(num_pings_ == 0) return 0;
+
+  // Searching for the bucket of the ping having the given rank, its upper bound is returned
+  const unsigned int rank = (num_pings_*percent + 99)/100;
+  unsigned int num_pings = 0;
+  for(unsigned int bucket = 0; bucket < num_ping_buckets; ++bucket) {
+    num_pings += ping_histogram_[bucket];
+    if(num_pings >= rank && num_pings != 0) {
+      if(bucket < num_fine_ping_buckets) return bucket;
+      if(bucket == num_ping_buckets - 1) return max_ping_;
+      return std::min(num_fine_ping_buckets + (bucket - num_fine_ping_buckets + 1)*ping_bucket_width_ - 1, max_ping_);
+    }
+  }
+
+  return max_ping_;
+}
+
+unsigned int Player::ping_bucket_(unsigned int ping) const {
+  if(ping < num_fine_ping_buckets) return ping;
+  return std::min(num_fine_ping_buckets + (ping - num_fine_ping_buckets)/ping_bucket_width_, num_ping_buckets - 1);
 }
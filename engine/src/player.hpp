@@ -34,6 +34,7 @@
 #include <cstdint>
 #include <qcolor.h>
 #include "basic_types.hpp"
+#include "protocol.hpp"
 
 namespace team_planets_engine {
   class Player {
@@ -53,12 +54,35 @@ namespace team_planets_engine {
     unsigned int num_ships() const { return num_ships_; }
     void set_num_ships(unsigned int num_ships) { num_ships_ = num_ships; }
 
+    // The last response time, all the response times are kept in the histogram
     unsigned int ping() const { return ping_; }
-    void set_ping(unsigned int ping) { ping_ = ping; }
+    void set_ping(unsigned int ping);
+
+    // Longest response time allowed to the bot (1000 ms by default), the histogram is sized for it so it must be
+    // set before the first response time
+    unsigned int ping_limit() const { return ping_limit_; }
+    void set_ping_limit(unsigned int ping_limit);
+
+    // Response times statistics over the whole battle
+    unsigned int num_pings() const { return num_pings_; }
+    unsigned int ping_percentile(unsigned int percent) const;
+    unsigned int max_ping() const { return max_ping_; }
+
+    // CPU time (user and system) used by the bot during the last turn and the whole battle, in ms
+    unsigned int cpu_time() const { return cpu_time_; }
+    void set_cpu_time(unsigned int cpu_time) { cpu_time_ = cpu_time; total_cpu_time_ += cpu_time; }
+    unsigned int total_cpu_time() const { return total_cpu_time_; }
+
+    // Remaining time bank in ms, when the battle is played with a time bank
+    unsigned int time_bank() const { return time_bank_; }
+    void set_time_bank(unsigned int time_bank) { time_bank_ = time_bank; }
 
     uint32_t message() const { return message_; }
     void set_message(uint32_t message) { message_ = message; }
 
+    team_planets::protocol_extensions extensions() const { return extensions_; }
+    void set_extensions(team_planets::protocol_extensions extensions) { extensions_ = extensions; }
+
   private:
     // Player properties
     team_planets::player_id id_;
@@ -72,8 +96,28 @@ namespace team_planets_engine {
 
     unsigned int            ping_;
 
+    // Response times histogram: 1 ms buckets up to 100 ms, 90 buckets up to the ping limit (10 ms wide with the
+    // default limit), then a last bucket
+    static const unsigned int num_fine_ping_buckets = 100;
+    static const unsigned int num_coarse_ping_buckets = 90;
+    static const unsigned int num_ping_buckets = num_fine_ping_buckets + num_coarse_ping_buckets + 1;
+    unsigned int ping_bucket_(unsigned int ping) const;
+
+    unsigned int            ping_limit_;
+    unsigned int            ping_bucket_width_; // Of the coarse buckets
+    unsigned int            ping_histogram_[num_ping_buckets];
+    unsigned int            num_pings_;
+    unsigned int            max_ping_;
+
+    unsigned int            cpu_time_;
+    unsigned int            total_cpu_time_;
+    unsigned int            time_bank_;
+
     // Player team message
     uint32_t                message_;
+
+    // Protocol extensions accepted by the bot
+    team_planets::protocol_extensions extensions_;
   };
 }
 
@@ -0,0 +1,252 @@
+// replay.cpp - Replay class implementation
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include <QtCore>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include "logger.hpp"
+#include "replay.hpp"
+
+using namespace std;
+using namespace team_planets;
+using namespace team_planets_engine;
+
+// Number of turns between two keyframes, seeking replays at most this number of turns
+static const unsigned int keyframe_interval = 10;
+
+// Number of arguments of each event
+static unsigned int event_num_arguments(uint8_t event) {
+  switch(event) {
+  case ReplayBeginTurn: return 1;
+  case ReplayLaunch: return 4;
+  case ReplayMessage: return 2;
+  case ReplayEliminate: return 2;
+  case ReplayPerformTurn: return 0;
+  case ReplayPlanet: return 3;
+  case ReplayEndBattle: return 2;
+  default: throw runtime_error("Unknown replay event.");
+  }
+}
+
+Replay::Replay():
+  team1_num_players_(0), team2_num_players_(0), turns_events_(1), complete_(false), winner_(0), current_turn_(0) {
+}
+
+void Replay::load(const string& file_name) {
+  ifstream in(file_name, ios::binary);
+  if(!in) throw runtime_error("Unable to load replay from " + file_name + ".");
+  const string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+
+  // Battle configuration
+  size_t pos = 0;
+  replay_check_available(data, pos, sizeof(replay_magic));
+  if(!equal(replay_magic, replay_magic + sizeof(replay_magic), data.begin()))
+    throw runtime_error(file_name + " is not a replay file.");
+  pos += sizeof(replay_magic);
+  if(replay_get_uint32(data, pos) != replay_version)
+    throw runtime_error("Unsupported version of replay file " + file_name + ".");
+
+  map_file_name_ = QString::fromStdString(replay_get_string(data, pos));
+  team1_bot_file_name_ = QString::fromStdString(replay_get_string(data, pos));
+  team1_num_players_ = replay_get_uint32(data, pos);
+  team2_bot_file_name_ = QString::fromStdString(replay_get_string(data, pos));
+  team2_num_players_ = replay_get_uint32(data, pos);
+  if(team1_num_players_ == 0 || team2_num_players_ == 0)
+    throw runtime_error("Invalid number of players in replay file " + file_name + ".");
+
+  // Initial map
+  const uint32_t num_planets = replay_get_uint32(data, pos);
+  vector<Planet> planets;
+  for(uint32_t i = 0; i < num_planets; ++i) {
+    const planet_id id = replay_get_uint32(data, pos);
+    const float x = replay_get_float(data, pos);
+    const float y = replay_get_float(data, pos);
+    const unsigned int ship_increase = replay_get_uint32(data, pos);
+    const player_id owner = replay_get_uint32(data, pos);
+    const unsigned int num_ships = replay_get_uint32(data, pos);
+
+    if(id == 0 || owner > team1_num_players_ + team2_num_players_)
+      throw runtime_error("Invalid planet in replay file " + file_name + ".");
+    planets.push_back(Planet(id, Coordinates(x, y), ship_increase, owner, num_ships));
+  }
+
+  // Splitting the events by turn
+  turns_events_.assign(1, string());
+  complete_ = false;
+  winner_ = 0;
+  while(pos < data.size() && !complete_) {
+    const size_t event_pos = pos;
+    const uint8_t event = replay_get_uint8(data, pos);
+    const unsigned int num_arguments = event_num_arguments(event);
+    replay_check_available(data, pos, 4*num_arguments);
+
+    if(event == ReplayBeginTurn) {
+      if(replay_get_uint32(data, pos) != turns_events_.size())
+        throw runtime_error("Invalid turn in replay file " + file_name + ".");
+      turns_events_.push_back(string());
+    } else if(event == ReplayEndBattle) {
+      replay_get_uint32(data, pos);
+      winner_ = replay_get_uint32(data, pos);
+      complete_ = true;
+    } else {
+      pos += 4*num_arguments;
+      turns_events_.back().append(data, event_pos, pos - event_pos);
+    }
+  }
+
+  // Playing the whole battle once, keeping the keyframes
+  map_.reset();
+  map_.load(planets);
+  create_players_();
+  keyframes_.clear();
+
+  for(current_turn_ = 0; current_turn_ <= num_turns(); ++current_turn_) {
+    play_turn_(current_turn_);
+    if(current_turn_ % keyframe_interval == 0) keyframes_.push_back(Keyframe_{ map_, players_ });
+  }
+  --current_turn_;
+
+  ENGINE_LOG(Info, "replay") << "Loaded replay from " << file_name << ": " << num_turns() << " turns.";
+}
+
+void Replay::seek(unsigned int turn) {
+  if(turn > num_turns()) turn = num_turns();
+
+  // Moving forward from the current turn if it is closer than the previous keyframe
+  if(turn < current_turn_ || turn/keyframe_interval != current_turn_/keyframe_interval) {
+    const Keyframe_& keyframe = keyframes_[turn/keyframe_interval];
+    map_ = keyframe.map;
+    players_ = keyframe.players;
+    current_turn_ = (turn/keyframe_interval)*keyframe_interval;
+  }
+
+  while(current_turn_ < turn) play_turn_(++current_turn_);
+}
+
+void Replay::create_players_() {
+  players_.clear();
+
+  // Same colors as in the battle
+  int cur_color = 255;
+  int color_step = 200/team1_num_players_;
+  for(unsigned int i = 0; i < team1_num_players_; ++i) {
+    players_.push_back(Player(players_.size() + 1, 1, QColor(cur_color, 0, 0)));
+    cur_color -= color_step;
+  }
+
+  cur_color = 255;
+  color_step = 200/team2_num_players_;
+  for(unsigned int i = 0; i < team2_num_players_; ++i) {
+    players_.push_back(Player(players_.size() + 1, 2, QColor(0, 0, cur_color)));
+    cur_color -= color_step;
+  }
+}
+
+void Replay::play_turn_(unsigned int turn) {
+  const string& events = turns_events_[turn];
+
+  size_t pos = 0;
+  while(pos < events.size()) {
+    switch(replay_get_uint8(events, pos)) {
+    case ReplayLaunch: {
+      const player_id player = replay_get_uint32(events, pos);
+      const planet_id source = replay_get_uint32(events, pos);
+      const planet_id destination = replay_get_uint32(events, pos);
+      const unsigned int num_ships = replay_get_uint32(events, pos);
+      map_.engine_launch_fleet(player, source, destination, num_ships);
+      break;
+    }
+
+    case ReplayMessage: {
+      const player_id player = replay_get_uint32(events, pos);
+      const uint32_t message = replay_get_uint32(events, pos);
+      if(player == 0 || player > players_.size()) throw runtime_error("Invalid player in replay.");
+      players_[player - 1].set_message(message);
+      break;
+    }
+
+    case ReplayEliminate: {
+      const player_id player = replay_get_uint32(events, pos);
+      const uint32_t reason = replay_get_uint32(events, pos);
+      if(player == 0 || player > players_.size()) throw runtime_error("Invalid player in replay.");
+
+      // Same as the battle elimination of the player
+      players_[player - 1].set_status(reason == ReplayPlayerDead ? Player::Dead : Player::Failed);
+      if(reason == ReplayPlayerCrashed) {
+        for_each(map_.planets_begin(), map_.planets_end(), [player](PlanetView planet) {
+          if(planet.current_owner() == player) planet.set_current_owner(neutral_player);
+        });
+      }
+      if(reason != ReplayPlayerKilled) map_.engine_eliminate_player_fleets(player);
+      break;
+    }
+
+    case ReplayPerformTurn:
+      map_.engine_perform_turn();
+      break;
+
+    case ReplayPlanet: {
+      const planet_id id = replay_get_uint32(events, pos);
+      const player_id owner = replay_get_uint32(events, pos);
+      const unsigned int num_ships = replay_get_uint32(events, pos);
+      if(id == 0 || id > map_.num_planets() || owner > players_.size())
+        throw runtime_error("Invalid planet in replay.");
+
+      map_.planet(id).set_current_owner(owner);
+      map_.planet(id).set_current_num_ships(num_ships);
+      break;
+    }
+    }
+  }
+
+  update_players_();
+}
+
+void Replay::update_players_() {
+  for(Player& player : players_) {
+    player.set_num_planets(0);
+    player.set_num_ships(0);
+  }
+
+  for_each(map_.planets_begin(), map_.planets_end(), [this](ConstPlanetView planet) {
+    if(planet.current_owner() != neutral_player) {
+      Player& owner = players_[planet.current_owner() - 1];
+      owner.set_num_planets(owner.num_planets() + 1);
+      owner.set_num_ships(owner.num_ships() + planet.current_num_ships());
+    }
+  });
+
+  for_each(map_.fleets_begin(), map_.fleets_end(), [this](const Fleet& fleet) {
+    Player& owner = players_[fleet.player() - 1];
+    owner.set_num_ships(owner.num_ships() + fleet.num_ships());
+  });
+}
@@ -0,0 +1,188 @@
+// replay.hpp - Replay file format definitions
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#ifndef _TEAMPLANETS_TEAMPLANETSENGINE_REPLAY_HPP_
+#define _TEAMPLANETS_TEAMPLANETSENGINE_REPLAY_HPP_
+
+#include <QString>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "map.hpp"
+#include "player.hpp"
+
+namespace team_planets_engine {
+  // Replay files are made of a header followed by a stream of events. All the values are 32 bits little
+  // endian integers (the floats are stored by their bits), except the event types which are single bytes.
+  //   header: magic version map_file_name team1_bot_file_name team1_num_players team2_bot_file_name
+  //           team2_num_players num_planets, then the planets: id x y ship_increase owner num_ships
+  //   events: type followed by its arguments, see ReplayEvent
+  // The strings are stored as their size followed by their bytes.
+  const char      replay_magic[4] = { 'T', 'P', 'R', 'P' };
+  const uint32_t  replay_version  = 1;
+
+  enum ReplayEvent {
+    ReplayBeginTurn = 1,  // turn
+    ReplayLaunch,         // player source destination num_ships
+    ReplayMessage,        // player message (only when the message changes)
+    ReplayEliminate,      // player reason
+    ReplayPerformTurn,    // no arguments, the engine performs the turn
+    ReplayPlanet,         // planet owner num_ships (at the end of the turn, only the changed planets)
+    ReplayEndBattle       // turns winner
+  };
+
+  // Elimination reasons, a crashed player planets become neutral and its fleets disappear, a dead player
+  // fleets disappear, a killed player is only stopped
+  enum ReplayEliminationReason { ReplayPlayerDead = 0, ReplayPlayerCrashed, ReplayPlayerKilled };
+
+  // Replay encoding
+  inline void replay_put_uint8(std::string& out, uint8_t value) {
+    out.push_back((char)value);
+  }
+
+  inline void replay_put_uint32(std::string& out, uint32_t value) {
+    const char bytes[4] = { (char)(value & 0xFF), (char)((value >> 8) & 0xFF),
+                            (char)((value >> 16) & 0xFF), (char)((value >> 24) & 0xFF) };
+    out.append(bytes, 4);
+  }
+
+  inline void replay_put_float(std::string& out, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    replay_put_uint32(out, bits);
+  }
+
+  inline void replay_put_string(std::string& out, const std::string& value) {
+    replay_put_uint32(out, (uint32_t)value.size());
+    out.append(value);
+  }
+
+  // Replay decoding, the position is moved after the decoded value
+  inline void replay_check_available(const std::string& in, std::size_t pos, std::size_t size) {
+    if(pos > in.size() || in.size() - pos < size) throw std::runtime_error("Truncated replay data.");
+  }
+
+  inline uint8_t replay_get_uint8(const std::string& in, std::size_t& pos) {
+    replay_check_available(in, pos, 1);
+    return (uint8_t)in[pos++];
+  }
+
+  inline uint32_t replay_get_uint32(const std::string& in, std::size_t& pos) {
+    replay_check_available(in, pos, 4);
+    const uint32_t value = (uint32_t)(uint8_t)in[pos] | ((uint32_t)(uint8_t)in[pos + 1] << 8)
+                           | ((uint32_t)(uint8_t)in[pos + 2] << 16) | ((uint32_t)(uint8_t)in[pos + 3] << 24);
+    pos += 4;
+    return value;
+  }
+
+  inline float replay_get_float(const std::string& in, std::size_t& pos) {
+    const uint32_t bits = replay_get_uint32(in, pos);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  inline std::string replay_get_string(const std::string& in, std::size_t& pos) {
+    const uint32_t size = replay_get_uint32(in, pos);
+    replay_check_available(in, pos, size);
+    pos += size;
+    return in.substr(pos - size, size);
+  }
+
+  // A recorded battle, which can be displayed at any turn. The state of the battle is kept at regular
+  // intervals (keyframes), seeking restores the closest previous keyframe and replays the few remaining turns.
+  class Replay {
+  private:
+    typedef std::vector<Player> players_list;
+
+  public:
+    typedef players_list::const_iterator  player_const_iterator;
+
+    Replay();
+
+    void load(const std::string& file_name);
+
+    // Battle configuration
+    const QString& map_file_name() const { return map_file_name_; }
+    const QString& team1_bot_file_name() const { return team1_bot_file_name_; }
+    unsigned int team1_num_players() const { return team1_num_players_; }
+    const QString& team2_bot_file_name() const { return team2_bot_file_name_; }
+    unsigned int team2_num_players() const { return team2_num_players_; }
+
+    // Battle results, the winner is only known if the battle have been recorded until the end
+    unsigned int num_turns() const { return (unsigned int)turns_events_.size() - 1; }
+    bool is_complete() const { return complete_; }
+    unsigned int winner() const { return winner_; }
+
+    // Moving to the end of a turn, the turn 0 is the beginning of the battle
+    unsigned int current_turn() const { return current_turn_; }
+    void seek(unsigned int turn);
+
+    // State of the battle at the current turn
+    const team_planets::Map& map() const { return map_; }
+
+    std::size_t num_players() const { return players_.size(); }
+    const Player& player(team_planets::player_id id) const { return players_[id - 1]; }
+    player_const_iterator players_begin() const { return players_.begin(); }
+    player_const_iterator players_end() const { return players_.end(); }
+
+  private:
+    struct Keyframe_ {
+      team_planets::Map map;
+      players_list      players;
+    };
+
+    void create_players_();
+    void play_turn_(unsigned int turn);
+    void update_players_();
+
+    // Battle configuration
+    QString       map_file_name_;
+    QString       team1_bot_file_name_;
+    unsigned int  team1_num_players_;
+    QString       team2_bot_file_name_;
+    unsigned int  team2_num_players_;
+
+    // The encoded events of each turn (the first ones precede the first turn) and the keyframes
+    std::vector<std::string>  turns_events_;
+    std::vector<Keyframe_>    keyframes_;
+    bool                      complete_;
+    unsigned int              winner_;
+
+    // Current state
+    unsigned int      current_turn_;
+    team_planets::Map map_;
+    players_list      players_;
+  };
+}
+
+#endif
@@ -0,0 +1,82 @@
+// replaywriter.cpp - ReplayWriter class implementation
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include <stdexcept>
+#include "replaywriter.hpp"
+
+using namespace std;
+using namespace team_planets_engine;
+
+ReplayWriter::ReplayWriter(const string& file_name, QObject* parent):
+  QThread(parent), file_(file_name, ios::binary | ios::trunc), closing_(false) {
+  if(!file_) throw runtime_error("Unable to create replay file " + file_name + ".");
+  start();
+}
+
+ReplayWriter::~ReplayWriter() {
+  close();
+}
+
+void ReplayWriter::write(string& data) {
+  mutex_.lock();
+  if(pending_data_.empty()) pending_data_.swap(data);
+  else pending_data_.append(data);
+  data.clear();
+  data_available_.wakeOne();
+  mutex_.unlock();
+}
+
+void ReplayWriter::close() {
+  mutex_.lock();
+  closing_ = true;
+  data_available_.wakeOne();
+  mutex_.unlock();
+
+  wait();
+}
+
+void ReplayWriter::run() {
+  string data;
+  bool   closing = false;
+
+  while(!closing) {
+    // Taking all the pending data at once
+    mutex_.lock();
+    while(pending_data_.empty() && !closing_) data_available_.wait(&mutex_);
+    data.swap(pending_data_);
+    closing = closing_;
+    mutex_.unlock();
+
+    file_.write(data.data(), data.size());
+    data.clear();
+  }
+
+  file_.flush();
+}
@@ -0,0 +1,93 @@
+// turnprofiler.cpp - TurnProfiler class implementation
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include <algorithm>
+#include <stdexcept>
+#include "turnprofiler.hpp"
+
+using namespace std;
+using namespace team_planets_engine;
+
+TurnProfiler::TurnProfiler(): num_turns_(0) {
+  fill(turn_durations_, turn_durations_ + NumPhases, clock::duration::zero());
+  fill(total_durations_, total_durations_ + NumPhases, clock::duration::zero());
+}
+
+const char* TurnProfiler::phase_name(Phase phase) {
+  switch(phase) {
+  case InputGeneration: return "input_generation";
+  case BotsIO: return "bots_io";
+  case OutputProcessing: return "output_processing";
+  case TurnPerforming: return "turn_performing";
+  case PlayersUpdate: return "players_update";
+  case ReplayRecording: return "replay_recording";
+  case Signalling: return "signalling";
+  default: return "unknown";
+  }
+}
+
+void TurnProfiler::open_turns_file(const string& file_name) {
+  turns_file_.open(file_name, ios::trunc);
+  if(!turns_file_) throw runtime_error("Unable to create profile file " + file_name + ".");
+
+  // The durations are in microseconds
+  turns_file_ << "turn";
+  for(int phase = 0; phase < NumPhases; ++phase) turns_file_ << ',' << phase_name((Phase)phase);
+  turns_file_ << endl;
+}
+
+void TurnProfiler::begin_turn() {
+  fill(turn_durations_, turn_durations_ + NumPhases, clock::duration::zero());
+  phase_start_ = clock::now();
+}
+
+void TurnProfiler::end_phase(Phase phase) {
+  const clock::time_point now = clock::now();
+  turn_durations_[phase] += now - phase_start_;
+  phase_start_ = now;
+}
+
+void TurnProfiler::end_turn(unsigned int turn) {
+  for(int phase = 0; phase < NumPhases; ++phase) total_durations_[phase] += turn_durations_[phase];
+  ++num_turns_;
+
+  if(turns_file_.is_open()) {
+    turns_file_ << turn;
+    for(int phase = 0; phase < NumPhases; ++phase)
+      turns_file_ << ',' << chrono::duration_cast<chrono::microseconds>(turn_durations_[phase]).count();
+    turns_file_ << '\n';
+  }
+}
+
+TurnProfiler::clock::duration TurnProfiler::total_duration() const {
+  clock::duration duration = clock::duration::zero();
+  for(int phase = 0; phase < NumPhases; ++phase) duration += total_durations_[phase];
+  return duration;
+}
@@ -0,0 +1,83 @@
+// turnprofiler.hpp - TurnProfiler class definition
+// TeamPlanetsEngine - TeamPlanets game engine
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#ifndef _TEAMPLANETS_TEAMPLANETSENGINE_TURNPROFILER_HPP_
+#define _TEAMPLANETS_TEAMPLANETSENGINE_TURNPROFILER_HPP_
+
+#include <chrono>
+#include <fstream>
+#include <string>
+
+namespace team_planets_engine {
+  // Measures the time spent by the engine in each phase of the turns. The phases are consecutive, each one
+  // ends where the next one begins, the durations of the battle are accumulated and can optionally be
+  // written turn by turn to a CSV file.
+  class TurnProfiler {
+  public:
+    typedef std::chrono::steady_clock clock;
+
+    enum Phase {
+      InputGeneration,    // Planets input of the bots
+      BotsIO,             // Sending the inputs and waiting for the outputs
+      OutputProcessing,   // Performing the orders
+      TurnPerforming,     // Engine turn
+      PlayersUpdate,      // Players statistics and eliminations
+      ReplayRecording,
+      Signalling,         // User interface snapshot and notification
+      NumPhases
+    };
+
+    TurnProfiler();
+
+    static const char* phase_name(Phase phase);
+
+    // Per turn CSV file, none by default
+    void open_turns_file(const std::string& file_name);
+
+    void begin_turn();
+    void end_phase(Phase phase);
+    void end_turn(unsigned int turn);
+
+    // Battle statistics
+    unsigned int num_turns() const { return num_turns_; }
+    clock::duration total_duration(Phase phase) const { return total_durations_[phase]; }
+    clock::duration total_duration() const;
+
+  private:
+    clock::time_point phase_start_;
+    clock::duration   turn_durations_[NumPhases];
+    clock::duration   total_durations_[NumPhases];
+    unsigned int      num_turns_;
+
+    std::ofstream     turns_file_;
+  };
+}
+
+#endif
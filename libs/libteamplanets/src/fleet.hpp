@@ -32,6 +32,7 @@
 #define _TEAMPLANETS_LIBTEAMPLANETS_FLEET_HPP_
 
 #include <cassert>
+#include <iostream>
 #include "basic_types.hpp"
 
 namespace team_planets {
@@ -39,11 +40,11 @@ namespace team_planets {
   public:
     Fleet():
       player_(neutral_player), source_(0), destination_(0),
-      num_ships_(0), remaining_turns_(0) {}
+      num_ships_(0), remaining_turns_(0), arrival_turn_(0) {}
     Fleet(player_id player, planet_id source, planet_id destination,
-          unsigned int num_ships, unsigned int remaining_turns):
+          unsigned int num_ships, unsigned int remaining_turns, unsigned int arrival_turn = 0):
       player_(player), source_(source), destination_(destination),
-      num_ships_(num_ships), remaining_turns_(remaining_turns) {}
+      num_ships_(num_ships), remaining_turns_(remaining_turns), arrival_turn_(arrival_turn) {}
 
     // Constant fleet data accessors
     player_id player() const { return player_; }
@@ -54,6 +55,9 @@ namespace team_planets {
     // Variable fleet data accessors
     unsigned int remaining_turns() const { return remaining_turns_; }
 
+    // Turn of the map on which the fleet arrives, for the fleets in flight of a map
+    unsigned int arrival_turn() const { return arrival_turn_; }
+
     // Various game mechanics functions
     void advance() { assert(remaining_turns_ != 0); --remaining_turns_; }
 
@@ -71,6 +75,7 @@ namespace team_planets {
 
     // Variable fleet data
     unsigned int        remaining_turns_;
+    unsigned int        arrival_turn_;
   };
 
   // Input/output operators
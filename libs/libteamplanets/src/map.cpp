@@ -37,10 +37,22 @@
 using namespace std;
 using namespace team_planets;
 
+// Reads a planet description line (after its tag) to the end of the records
+static void read_planet(istream& in, vector<Planet>& records) {
+  Planet planet;
+  in >> planet;
+  records.push_back(planet);
+}
+
 // Map loading functions
 void Map::reset() {
   planets_.clear();
   fleets_.clear();
+  fleets_turn_ = 0;
+  num_fleets_ = 0;
+  incoming_.clear();
+  received_planets_.reset();
+  travel_distances_.reset();
 }
 
 void Map::load(const string& file_name) {
@@ -48,40 +60,39 @@ void Map::load(const string& file_name) {
   if(!in) throw runtime_error("Unable to load map from " + file_name + ".");
 
   // Loading planets in order
-  planets_list tmp_list;
+  vector<Planet> tmp_list;
   while(in) {
     string tag;
     in >> tag;
 
     if(tag == string("P")) {
-      Planet P;
-      in >> P;
-
-      assert(P.id() != 0);
-      tmp_list.push_back(P);
+      read_planet(in, tmp_list);
+      assert(tmp_list.back().id() != 0);
     }
   }
 
-  // Placing planets at correct positions (even if there is holes in planet's IDs)
-  planet_id max_id = 0;
-  for_each(tmp_list.begin(), tmp_list.end(), [&max_id](const Planet& P) {
-    if(P.id() > max_id) max_id = P.id();
-  });
+  load(tmp_list);
+}
 
-  planets_.resize(max_id);
-  for_each(tmp_list.begin(), tmp_list.end(), [this](const Planet& P) {
-    planets_[P.id() - 1] = P;
-  });
+void Map::load(const vector<Planet>& planets) {
+  planets_.assign(planets.begin(), planets.end());
+  compute_travel_distances_();
 }
 
 // Game mechanics for bot
 void Map::bot_begin_turn() {
-  // Clear the map before update
-  planets_.clear();
+  // Clear the orders before update
   pending_orders_.clear();
+  reset_requested_ = false;
+  turn_time_ = 0;
+  time_bank_ = 0;
 
   // Reading the input from the engine
   read_bot_input_();
+  if(reset_requested_) {
+    reset_bot_();
+    return;
+  }
 
   // Updating game status
   update_fleets_();
@@ -92,29 +103,66 @@ void Map::bot_end_turn() {
   write_bot_output_();
 }
 
+void Map::bot_begin_turn(const teamplanets_turn_input& input) {
+  pending_orders_.clear();
+  reset_requested_ = false;
+
+  // The planets are always full records, no need to keep them for the next delta
+  myself_ = input.myself;
+  message_ = input.message;
+  turn_time_ = input.turn_time;
+  time_bank_ = input.time_bank;
+  place_planets_(input.planets, input.num_planets, planets_);
+  if(!travel_distances_) compute_travel_distances_();
+
+  // Updating game status
+  update_fleets_();
+  remove_arrived_fleets_();
+}
+
+void Map::bot_end_turn(teamplanets_turn_output& output) {
+  generate_order_records_();
+  output.message = message_;
+  output.num_orders = (uint32_t)order_records_.size();
+  output.orders = order_records_.data();
+}
+
+void Map::bot_reset() {
+  pending_orders_.clear();
+  reset_bot_();
+}
+
 void Map::bot_launch_fleet(planet_id source, planet_id destination, unsigned int num_ships) {
   // Perform the launch
   planet(source).remove_ships(num_ships);
-  fleets_.push_back(Fleet(planet(source).current_owner(), source, destination, num_ships,
-                          planet(destination).compute_travel_distance(planet(source))));
+  add_fleet_(planet(source).current_owner(), source, destination, num_ships);
 
   // Store the pending order
   pending_orders_.push_back(Fleet(planet(source).current_owner(), source, destination, num_ships,
-                            planet(destination).compute_travel_distance(planet(source))));
+                            travel_distance(source, destination)));
 }
 
 bool Map::bot_planet_is_targeted_by_a_fleet(planet_id id) const {
-  auto it = find_if(fleets_.begin(), fleets_.end(), [id](const Fleet& fleet) {
-    return fleet.destination() == id;
+  auto ships = incoming_ships_to_(id);
+  return any_of(ships.first, ships.second, [](const IncomingShips& incoming) {
+    return incoming.player != neutral_player;
   });
-  return it != end(fleets_);
 }
 
 bool Map::bot_planet_is_targeted_by_my_fleet(planet_id id) const {
-  auto it = find_if(fleets_.begin(), fleets_.end(), [this, id](const Fleet& fleet) {
-    return  fleet.player() == myself_ && fleet.destination() == id;
+  auto ships = incoming_ships_to_(id);
+  return any_of(ships.first, ships.second, [this](const IncomingShips& incoming) {
+    return incoming.player == myself_;
   });
-  return it != end(fleets_);
+}
+
+unsigned int Map::incoming_ships(planet_id id, player_id player, unsigned int num_turns) const {
+  auto ships = incoming_ships_to_(id);
+  unsigned int num_ships = 0;
+  for(auto it = ships.first; it != ships.second; ++it) {
+    if(it->player == player && it->arrival_turn - fleets_turn_ <= num_turns) num_ships += it->num_ships;
+  }
+  return num_ships;
 }
 
 // Game mechanics for engine
@@ -138,29 +186,111 @@ void Map::engine_launch_fleet(player_id player, planet_id source, planet_id dest
 
   // Performing the order
   planet(source).remove_ships(num_ships);
-  fleets_.push_back(Fleet(player, source, destination, num_ships,
-                          planet(destination).compute_travel_distance(planet(source))));
+  add_fleet_(player, source, destination, num_ships);
 }
 
 void Map::engine_eliminate_player_fleets(player_id player) {
-  fleet_iterator new_end = remove_if(fleets_.begin(), fleets_.end(), [player](const Fleet& fleet) {
-    return fleet.player() == player;
-  });
-  fleets_.erase(new_end, fleets_.end());
+  for(fleets_list& bucket:fleets_) {
+    auto new_end = remove_if(bucket.begin(), bucket.end(), [player](const Fleet& fleet) {
+      return fleet.player() == player;
+    });
+    num_fleets_ -= bucket.end() - new_end;
+    bucket.erase(new_end, bucket.end());
+  }
+
+  for(IncomingShips& incoming:incoming_) {
+    if(incoming.player == player) free_incoming_ships_(incoming);
+  }
 }
 
 // Private common game mechanics
-void Map::update_fleets_() {
-  for_each(fleets_.begin(), fleets_.end(), [](Fleet& fleet) {
-    fleet.advance();
+void Map::add_fleet_(player_id player, planet_id source, planet_id destination, unsigned int num_ships) {
+  // The wheel must have a bucket for each possible travel distance
+  const unsigned int travel = travel_distance(source, destination);
+  if(travel >= fleets_.size()) resize_fleets_wheel_(max<size_t>(travel + 1, 2*fleets_.size()));
+
+  const unsigned int arrival_turn = fleets_turn_ + travel;
+  fleets_[arrival_turn % fleets_.size()].push_back(Fleet(player, source, destination, num_ships, travel,
+                                                         arrival_turn));
+  ++num_fleets_;
+
+  // Indexing the ships by destination, a free entry of the destination is reused before growing the index
+  auto ships = incoming_ships_to_(destination);
+  auto it = find_if(ships.first, ships.second, [player, arrival_turn](const IncomingShips& incoming) {
+    return incoming.player == player && incoming.arrival_turn == arrival_turn;
   });
+  if(it == ships.second) {
+    it = find_if(ships.first, ships.second, [](const IncomingShips& incoming) {
+      return incoming.player == neutral_player;
+    });
+  }
+
+  if(it != ships.second) {
+    IncomingShips& incoming = incoming_[it - incoming_.begin()];
+    if(incoming.player == neutral_player) {
+      incoming.player = player;
+      incoming.arrival_turn = arrival_turn;
+    }
+    incoming.num_ships += num_ships;
+  } else {
+    IncomingShips incoming;
+    incoming.destination = destination;
+    incoming.player = player;
+    incoming.num_ships = num_ships;
+    incoming.arrival_turn = arrival_turn;
+    incoming_.insert(ships.second, incoming);
+  }
+}
+
+void Map::resize_fleets_wheel_(size_t size) {
+  // The fleets are moved bucket by bucket in the arrival order, so they stay in the launch order
+  fleets_wheel wheel(size);
+  for(size_t offset = 0; offset < fleets_.size(); ++offset) {
+    fleets_list& bucket = fleets_[(fleets_turn_ + offset) % fleets_.size()];
+    if(!bucket.empty()) wheel[(fleets_turn_ + offset) % size] = move(bucket);
+  }
+  fleets_.swap(wheel);
+}
+
+void Map::update_fleets_() {
+  ++fleets_turn_;
 }
 
 void Map::remove_arrived_fleets_() {
-  fleet_iterator new_end = remove_if(fleets_.begin(), fleets_.end(), [](const Fleet& fleet) {
-    return fleet.remaining_turns() == 0;
+  if(fleets_.empty()) return;
+
+  // Only the index entries of the arrived fleets destinations are freed, the index itself is never shrunk
+  fleets_list& bucket = arrived_fleets_();
+  for(const Fleet& fleet:bucket) {
+    if(fleet.arrival_turn() != fleets_turn_) continue;
+
+    auto ships = incoming_ships_to_(fleet.destination());
+    for(auto it = ships.first; it != ships.second; ++it) {
+      IncomingShips& incoming = incoming_[it - incoming_.begin()];
+      if(incoming.player != neutral_player && incoming.arrival_turn == fleets_turn_) free_incoming_ships_(incoming);
+    }
+  }
+
+  // The fleets sent at a zero distance stay in the bucket
+  auto new_end = remove_if(bucket.begin(), bucket.end(), [this](const Fleet& fleet) {
+    return fleet.arrival_turn() == fleets_turn_;
+  });
+  num_fleets_ -= bucket.end() - new_end;
+  bucket.erase(new_end, bucket.end());
+}
+
+void Map::free_incoming_ships_(IncomingShips& incoming) {
+  incoming.player = neutral_player;
+  incoming.num_ships = 0;
+}
+
+pair<Map::incoming_list::const_iterator, Map::incoming_list::const_iterator>
+Map::incoming_ships_to_(planet_id id) const {
+  assert(id != 0);
+  const IncomingShips key = {id, neutral_player, 0, 0};
+  return equal_range(incoming_.begin(), incoming_.end(), key, [](const IncomingShips& a, const IncomingShips& b) {
+    return a.destination < b.destination;
   });
-  fleets_.erase(new_end, fleets_.end());
 }
 
 void Map::perform_battles_() {
@@ -169,92 +299,127 @@ void Map::perform_battles_() {
     player_id     player;
     unsigned int  num_ships;
   };
-  typedef vector<Force>       forces_list;
-  typedef vector<forces_list> planetary_forces_list;
 
-  // Initializing the list of forces
-  planetary_forces_list forces_per_planet;
-  forces_per_planet.resize(planets_.size());
+  // The forces of all the planets in one buffer, each planet having a slot per arrived fleet after the owner
+  // force. The buffers are kept between the calls, so the turns are performed without allocation.
+  static thread_local vector<Force>   forces;
+  static thread_local vector<size_t>  first_force;
+  static thread_local vector<size_t>  num_forces;
+
+  static const fleets_list no_fleets;
+  const fleets_list& arrived_fleets = fleets_.empty() ? no_fleets : arrived_fleets_();
+
+  first_force.assign(planets_.size() + 1, 0);
+  for(const Fleet& fleet:arrived_fleets) {
+    if(fleet.arrival_turn() == fleets_turn_) ++first_force[fleet.destination()];
+  }
+  for(planet_id id = 1; id <= planets_.size(); ++id) first_force[id] += first_force[id - 1] + 1;
+
+  // Initializing the forces with the planets owners
+  forces.resize(first_force[planets_.size()]);
+  num_forces.assign(planets_.size(), 1);
   for(planet_id id = 1; id <= planets_.size(); ++id) {
-    forces_list& forces = forces_per_planet[id - 1];
-    forces.push_back(Force());
-    forces.back().player = planets_[id - 1].current_owner();
-    forces.back().num_ships = planets_[id - 1].current_num_ships();
+    Force& force = forces[first_force[id - 1]];
+    force.player = planets_.owners()[id - 1];
+    force.num_ships = planets_.num_ships()[id - 1];
   }
 
-  // Classifying arrived fleets by planets and creating forces
-  for(const Fleet& fleet:fleets_) {
-    if(fleet.remaining_turns() == 0) {
-      forces_list& forces = forces_per_planet[fleet.destination() - 1];
-
-      // Searching player force
-      Force* player_force = nullptr;
-      bool   found        = false;
-      for(Force& force:forces) {
-        if(force.player == fleet.player()) {
-          player_force = &force;
-          found = true;
-        }
-      }
+  // Classifying arrived fleets by planets and creating forces, in the launch order
+  for(const Fleet& fleet:arrived_fleets) {
+    if(fleet.arrival_turn() != fleets_turn_) continue;
 
-      // Updating the force accrodingly
-      if(found) player_force->num_ships += fleet.num_ships();
-      else {
-        forces.push_back(Force());
-        forces.back().player = fleet.player();
-        forces.back().num_ships = fleet.num_ships();
-      }
+    Force* const planet_forces = &forces[first_force[fleet.destination() - 1]];
+    size_t&      num_planet_forces = num_forces[fleet.destination() - 1];
+
+    // Searching player force
+    Force* player_force = nullptr;
+    for(size_t i = 0; i < num_planet_forces; ++i) {
+      if(planet_forces[i].player == fleet.player()) player_force = &planet_forces[i];
+    }
+
+    // Updating the force accrodingly
+    if(player_force) player_force->num_ships += fleet.num_ships();
+    else {
+      planet_forces[num_planet_forces].player = fleet.player();
+      planet_forces[num_planet_forces].num_ships = fleet.num_ships();
+      ++num_planet_forces;
     }
   }
 
   // Performing battles
-  for(planet_id id = 1; id <= forces_per_planet.size(); ++id) {
-    Planet& planet = planets_[id - 1];
-    forces_list& forces = forces_per_planet[id - 1];
+  for(planet_id id = 1; id <= planets_.size(); ++id) {
+    PlanetView planet = planets_[id - 1];
+    const Force* const planet_forces = &forces[first_force[id - 1]];
 
-    if(forces.size() > 1) {
+    if(num_forces[id - 1] > 1) {
       // Searching the largest and second largest force
       size_t max_force = 0, second_max = 1;
-      for(size_t i = 1; i < forces.size(); ++i) {
-        if(forces[i].num_ships >= forces[max_force].num_ships) {
+      for(size_t i = 1; i < num_forces[id - 1]; ++i) {
+        if(planet_forces[i].num_ships >= planet_forces[max_force].num_ships) {
           second_max = max_force;
           max_force = i;
         }
       }
 
       // If the forces are equal, current owner keeps the planet
-      if(forces[max_force].num_ships == forces[second_max].num_ships) planet.set_current_num_ships(0);
+      if(planet_forces[max_force].num_ships == planet_forces[second_max].num_ships) planet.set_current_num_ships(0);
       else {
         // Max force wins the planet
-        planet.set_current_owner(forces[max_force].player);
-        planet.set_current_num_ships(forces[max_force].num_ships - forces[second_max].num_ships);
+        planet.set_current_owner(planet_forces[max_force].player);
+        planet.set_current_num_ships(planet_forces[max_force].num_ships - planet_forces[second_max].num_ships);
       }
     } else {
       // The force returns to the planet
-      planet.set_current_num_ships(forces[0].num_ships);
+      planet.set_current_num_ships(planet_forces[0].num_ships);
     }
   }
 }
 
 void Map::update_planets_() {
-  for_each(planets_.begin(), planets_.end(), [](Planet& planet) {
-    if(planet.current_owner() != neutral_player) planet.produce_new_ships();
-  });
+  // Branchless on the arrays, so that the loop is vectorized
+  const vector<player_id>&    owners = planets_.owners();
+  const vector<unsigned int>& ship_increases = planets_.ship_increases();
+  vector<unsigned int>&       num_ships = planets_.num_ships();
+  for(size_t i = 0; i < num_ships.size(); ++i)
+    num_ships[i] += (owners[i] != neutral_player) ? ship_increases[i] : 0;
+}
+
+void Map::compute_travel_distances_() {
+  const size_t num_planets = planets_.size();
+  shared_ptr<vector<uint16_t>> distances = make_shared<vector<uint16_t>>(num_planets*num_planets);
+
+  // The distance is symmetric, each pair is computed once
+  for(size_t i = 0; i < num_planets; ++i) {
+    for(size_t j = i + 1; j < num_planets; ++j) {
+      const unsigned int distance = planets_[i].compute_travel_distance(planets_[j]);
+      if(distance > UINT16_MAX) throw runtime_error("The map is too large.");
+
+      (*distances)[i*num_planets + j] = (uint16_t)distance;
+      (*distances)[j*num_planets + i] = (uint16_t)distance;
+    }
+  }
+
+  travel_distances_ = distances;
 }
 
 // Private bot game mechanics
 void Map::read_bot_input_() {
+  if(binary_protocol_) {
+    read_bot_binary_input_();
+    return;
+  }
+
   string tag;
-  planets_list tmp_list;
+  vector<Planet> tmp_list;
+  if(!received_planets_) received_planets_ = make_shared<planets_list>();
+  planets_list& received_planets = *received_planets_;
 
   do {
     cin >> tag;
 
     if(tag == string("P")) {
       // Planet description line
-      Planet P;
-      cin >> P;
-      tmp_list.push_back(P);
+      read_planet(cin, tmp_list);
     }
 
     if(tag == string("M")) {
@@ -266,21 +431,136 @@ void Map::read_bot_input_() {
       // Current player identifier
       cin >> myself_;
     }
+
+    if(tag == string("D")) {
+      // Changed planet line (delta protocol)
+      planet_id     id;
+      player_id     owner;
+      unsigned int  num_ships;
+      cin >> id >> owner >> num_ships;
+
+      assert(id != 0);
+      assert(id - 1 < received_planets.size());
+      received_planets[id - 1].set_current_owner(owner);
+      received_planets[id - 1].set_current_num_ships(num_ships);
+    }
+
+    if(tag == string("T")) {
+      // Time control
+      cin >> turn_time_ >> time_bank_;
+    }
+
+    if(tag == string("R")) {
+      // End of the game
+      reset_requested_ = true;
+    }
+
+    if(tag == string("X")) {
+      // Protocol extensions offered by the engine
+      protocol_extensions offered_extensions;
+      cin >> offered_extensions;
+      accepted_extensions_ = offered_extensions & requested_extensions_;
+      extensions_answer_pending_ = true;
+    }
   } while(tag != string("."));
 
-  // Placing planets at correct positions (even if there is holes in planet's IDs)
-  planet_id max_id = 0;
-  for_each(tmp_list.begin(), tmp_list.end(), [&max_id](const Planet& P) {
-    if(P.id() > max_id) max_id = P.id();
-  });
+  if(!tmp_list.empty()) received_planets.assign(tmp_list.begin(), tmp_list.end());
 
-  planets_.resize(max_id);
-  for_each(tmp_list.begin(), tmp_list.end(), [this](const Planet& P) {
-    planets_[P.id() - 1] = P;
-  });
+  // The bot works on a copy, the received planets must stay untouched for the next delta
+  planets_ = received_planets;
+  if(!travel_distances_) compute_travel_distances_();
+}
+
+void Map::read_bot_binary_input_() {
+  // Skipping the end of the last text line
+  if(newline_pending_) {
+    cin.get();
+    newline_pending_ = false;
+  }
+
+  BinaryInputHeader header;
+  if(!cin.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    throw runtime_error("Unable to read the engine input.");
+
+  if(header.flags & binary_reset) {
+    reset_requested_ = true;
+    return;
+  }
+
+  myself_ = header.myself;
+  message_ = header.message;
+
+  if(header.flags & binary_time_bank) {
+    BinaryTimeBank record;
+    if(!cin.read(reinterpret_cast<char*>(&record), sizeof(record)))
+      throw runtime_error("Unable to read the engine input.");
+    turn_time_ = record.turn_time;
+    time_bank_ = record.time_bank;
+  }
+
+  if(!received_planets_) received_planets_ = make_shared<planets_list>();
+  planets_list& received_planets = *received_planets_;
+  if(header.flags & binary_full_planets) {
+    vector<BinaryPlanet> records(header.num_planets);
+    if(!cin.read(reinterpret_cast<char*>(records.data()), records.size()*sizeof(BinaryPlanet)))
+      throw runtime_error("Unable to read the engine input.");
+    place_planets_(records.data(), records.size(), received_planets);
+  } else {
+    vector<BinaryPlanetDelta> records(header.num_planets);
+    if(!cin.read(reinterpret_cast<char*>(records.data()), records.size()*sizeof(BinaryPlanetDelta)))
+      throw runtime_error("Unable to read the engine input.");
+
+    for(const BinaryPlanetDelta& record:records) {
+      assert(record.id != 0);
+      assert(record.id - 1 < received_planets.size());
+      received_planets[record.id - 1].set_current_owner(record.owner);
+      received_planets[record.id - 1].set_current_num_ships(record.num_ships);
+    }
+  }
+
+  // The bot works on a copy, the received planets must stay untouched for the next delta
+  planets_ = received_planets;
+  if(!travel_distances_) compute_travel_distances_();
+}
+
+void Map::place_planets_(const BinaryPlanet* records, size_t num_records, planets_list& planets) {
+  vector<Planet> tmp_list;
+  tmp_list.reserve(num_records);
+  for(size_t i = 0; i < num_records; ++i) {
+    const BinaryPlanet& record = records[i];
+    tmp_list.push_back(Planet(record.id, Coordinates(record.x, record.y), record.ship_increase, record.owner,
+                              record.num_ships));
+  }
+
+  planets.assign(tmp_list.begin(), tmp_list.end());
+}
+
+void Map::reset_bot_() {
+  // Forgetting the game, the protocol goes back to text until the next negotiation
+  planets_.clear();
+  fleets_.clear();
+  fleets_turn_ = 0;
+  num_fleets_ = 0;
+  incoming_.clear();
+  received_planets_.reset();
+  travel_distances_.reset();
+  myself_ = neutral_player;
+  message_ = 0;
+  turn_time_ = 0;
+  time_bank_ = 0;
+
+  accepted_extensions_ = no_extensions;
+  extensions_answer_pending_ = false;
+  binary_protocol_ = false;
+  newline_pending_ = false;
 }
 
 void Map::write_bot_output_() {
+  if(binary_protocol_) {
+    write_bot_binary_output_();
+    return;
+  }
+
   // Writing pending orders
   for_each(pending_orders_.begin(), pending_orders_.end(), [](const Fleet& fleet) {
     cout << fleet << endl;
@@ -289,6 +569,42 @@ void Map::write_bot_output_() {
   // Writing the message for the team
   cout << "M " << message_ << endl;
 
+  // Answering the protocol extensions offer
+  if(extensions_answer_pending_) {
+    cout << "X " << accepted_extensions_ << endl;
+    extensions_answer_pending_ = false;
+
+    // The next inputs and outputs are binary frames
+    if(accepted_extensions_ & binary_extension) {
+      binary_protocol_ = true;
+      newline_pending_ = true;
+    }
+  }
+
   cout << "." << endl;
   cout.flush();
 }
+
+void Map::write_bot_binary_output_() {
+  generate_order_records_();
+
+  BinaryOutputHeader header;
+  header.size = (uint32_t)(sizeof(header) + order_records_.size()*sizeof(BinaryOrder));
+  header.message = message_;
+  header.num_orders = (uint32_t)order_records_.size();
+
+  cout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  cout.write(reinterpret_cast<const char*>(order_records_.data()), order_records_.size()*sizeof(BinaryOrder));
+  cout.flush();
+}
+
+void Map::generate_order_records_() {
+  order_records_.clear();
+  for(const Fleet& fleet:pending_orders_) {
+    BinaryOrder record;
+    record.source = fleet.source();
+    record.destination = fleet.destination();
+    record.num_ships = fleet.num_ships();
+    order_records_.push_back(record);
+  }
+}
@@ -33,65 +33,157 @@
 
 #include <cassert>
 #include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
 #include <vector>
 #include <string>
 #include "planet.hpp"
 #include "fleet.hpp"
+#include "protocol.hpp"
+#include "plugin.hpp"
 
 namespace team_planets {
   class Map {
   private:
-    typedef std::vector<Planet> planets_list;
+    typedef PlanetStore         planets_list;
     typedef std::vector<Fleet>  fleets_list;
+    typedef std::vector<fleets_list> fleets_wheel;
+
+    // Ships of a player heading to a planet and arriving on the same turn, a free entry belongs to the neutral player
+    struct IncomingShips {
+      planet_id     destination;
+      player_id     player;
+      unsigned int  num_ships;
+      unsigned int  arrival_turn;
+    };
+    typedef std::vector<IncomingShips>  incoming_list;
 
   public:
+    // Iterator over the fleets in flight by arrival turn, it holds a copy of the current fleet
+    class FleetIterator: public std::iterator<std::forward_iterator_tag, Fleet, std::ptrdiff_t, const Fleet*,
+                                              const Fleet&> {
+    public:
+      FleetIterator(const fleets_wheel& wheel, unsigned int turn, std::size_t offset):
+        wheel_(&wheel), turn_(turn), offset_(offset), index_(0) { skip_empty_buckets_(); }
+
+      const Fleet& operator*() const {
+        const Fleet& fleet = bucket_()[index_];
+        fleet_ = Fleet(fleet.player(), fleet.source(), fleet.destination(), fleet.num_ships(),
+                       fleet.arrival_turn() - turn_, fleet.arrival_turn());
+        return fleet_;
+      }
+      const Fleet* operator->() const { return &**this; }
+
+      FleetIterator& operator++() { ++index_; skip_empty_buckets_(); return *this; }
+      FleetIterator operator++(int) { FleetIterator it = *this; ++*this; return it; }
+
+      bool operator==(const FleetIterator& it) const { return offset_ == it.offset_ && index_ == it.index_; }
+      bool operator!=(const FleetIterator& it) const { return !(*this == it); }
+
+    private:
+      const fleets_list& bucket_() const { return (*wheel_)[(turn_ + offset_) % wheel_->size()]; }
+      void skip_empty_buckets_() {
+        while(offset_ < wheel_->size() && index_ >= bucket_().size()) {
+          ++offset_;
+          index_ = 0;
+        }
+      }
+
+      const fleets_wheel* wheel_;
+      unsigned int        turn_;
+      std::size_t         offset_;  // Bucket, from the one of the current turn
+      std::size_t         index_;   // Fleet in the bucket
+      mutable Fleet       fleet_;
+    };
+
     typedef planets_list::iterator        planet_iterator;
     typedef planets_list::const_iterator  planet_const_iterator;
-    typedef fleets_list::iterator         fleet_iterator;
-    typedef fleets_list::const_iterator   fleet_const_iterator;
+    typedef FleetIterator                 fleet_iterator;
+    typedef FleetIterator                 fleet_const_iterator;
 
-    Map(): myself_(neutral_player), message_(0) {}
+    Map():
+      fleets_turn_(0), num_fleets_(0), myself_(neutral_player), message_(0), turn_time_(0), time_bank_(0),
+      requested_extensions_(delta_extension | binary_extension | time_bank_extension),
+      accepted_extensions_(no_extensions),
+      extensions_answer_pending_(false), binary_protocol_(false), newline_pending_(false),
+      reset_requested_(false) {}
 
     // Map loading functions
     void reset();
     void load(const std::string& file_name);
+    void load(const std::vector<Planet>& planets);
 
-    // Planets accessors
+    // Planets accessors, the planets are views of the planets store
     std::size_t num_planets() const { return planets_.size(); }
-    Planet& planet(planet_id id) {
+    PlanetView planet(planet_id id) {
       assert(id != 0);
       assert(id - 1 < planets_.size());
 
       return planets_[id - 1];
     }
-    const Planet& planet(planet_id id) const {
+    ConstPlanetView planet(planet_id id) const {
       assert(id != 0);
       assert(id - 1 < planets_.size());
 
       return planets_[id - 1];
     }
 
+    // Travel distance between two planets in turns, the same as Planet::compute_travel_distance() but read from
+    // the matrix computed once the planets are loaded or received
+    unsigned int travel_distance(planet_id source, planet_id destination) const {
+      assert(source != 0 && destination != 0);
+      assert(source - 1 < planets_.size() && destination - 1 < planets_.size());
+      assert(travel_distances_);
+
+      return (*travel_distances_)[(source - 1)*planets_.size() + destination - 1];
+    }
+
     planet_iterator planets_begin() { return planets_.begin(); }
     planet_const_iterator planets_begin() const { return planets_.begin(); }
     planet_iterator planets_end() { return planets_.end(); }
     planet_const_iterator planets_end() const { return planets_.end(); }
 
-    // Fleets accessors
-    std::size_t num_fleets() const { return fleets_.size(); }
-    fleet_iterator fleets_begin() { return fleets_.begin(); }
-    fleet_const_iterator fleets_begin() const { return fleets_.begin(); }
-    fleet_iterator fleets_end() { return fleets_.end(); }
-    fleet_const_iterator fleets_end() const { return fleets_.end(); }
+    // The planets fields as arrays, for the scans over all the planets
+    const PlanetStore& planets() const { return planets_; }
+
+    // Fleets accessors, the fleets in flight are given in the order of their arrival
+    std::size_t num_fleets() const { return num_fleets_; }
+    fleet_const_iterator fleets_begin() const { return FleetIterator(fleets_, fleets_turn_, 0); }
+    fleet_const_iterator fleets_end() const { return FleetIterator(fleets_, fleets_turn_, fleets_.size()); }
+
+    // Number of ships of a player heading to a planet and arriving in at most num_turns turns
+    unsigned int incoming_ships(planet_id id, player_id player,
+                                unsigned int num_turns = std::numeric_limits<unsigned int>::max()) const;
 
     // Accessors for bot
     player_id myself() const { return myself_; }
     uint32_t message() const { return message_; }
     void set_message(uint32_t message) { message_ = message; }
 
+    // Time control of the current turn in ms (see protocol.hpp), both are null if the engine don't send it
+    unsigned int turn_time() const { return turn_time_; }
+    unsigned int time_bank() const { return time_bank_; }
+
+    // Protocol extensions the bot accepts if the engine offers them (before the first turn)
+    protocol_extensions requested_protocol_extensions() const { return requested_extensions_; }
+    void set_requested_protocol_extensions(protocol_extensions extensions) { requested_extensions_ = extensions; }
+    protocol_extensions accepted_protocol_extensions() const { return accepted_extensions_; }
+
+    // True if the engine have ended the game instead of sending a new turn (requires the reset extension),
+    // the map is then empty and bot_end_turn() acknowledges the reset
+    bool bot_reset_requested() const { return reset_requested_; }
+
     // Game mechanics for bot
     void bot_begin_turn();
     void bot_end_turn();
 
+    // In-process bots (see plugin.hpp), the turn input and output are exchanged in memory instead of the
+    // standard input and output, and the reset is requested directly. The output is valid until the next turn.
+    void bot_begin_turn(const teamplanets_turn_input& input);
+    void bot_end_turn(teamplanets_turn_output& output);
+    void bot_reset();
+
     void bot_launch_fleet(planet_id source, planet_id destination, unsigned int num_ships);
     bool bot_planet_is_targeted_by_a_fleet(planet_id id) const;
     bool bot_planet_is_targeted_by_my_fleet(planet_id id) const;
@@ -103,25 +195,68 @@ namespace team_planets {
 
   private:
     // Private common game mechanics
+    void add_fleet_(player_id player, planet_id source, planet_id destination, unsigned int num_ships);
+    void resize_fleets_wheel_(std::size_t size);
+    std::pair<incoming_list::const_iterator, incoming_list::const_iterator> incoming_ships_to_(planet_id id) const;
+    fleets_list& arrived_fleets_() { return fleets_[fleets_turn_ % fleets_.size()]; }
     void update_fleets_();
     void remove_arrived_fleets_();
+    static void free_incoming_ships_(IncomingShips& incoming);
 
     void perform_battles_();
 
     void update_planets_();
 
+    void compute_travel_distances_();
+
     // Private bot game mechanics
     void read_bot_input_();
+    void read_bot_binary_input_();
+    static void place_planets_(const BinaryPlanet* records, std::size_t num_records, planets_list& planets);
+    void reset_bot_();
     void write_bot_output_();
+    void write_bot_binary_output_();
+    void generate_order_records_();
 
     // Map description common for engine and bots
     planets_list  planets_;
-    fleets_list   fleets_;
+
+    // Fleets in flight bucketed by arrival turn (timing wheel): the fleets arriving on the turn t are in the bucket
+    // t % size, in the launch order, so a turn only touches the arriving fleets. The remaining turns of the stored
+    // fleets are only computed by the iterators. A fleet sent at a zero distance is never due: its remaining
+    // turns wrap around as in the original rules, it stays in flight.
+    fleets_wheel  fleets_;
+    unsigned int  fleets_turn_;   // Number of turns the fleets have advanced
+    std::size_t   num_fleets_;
+
+    // The same fleets summed by player and arrival turn, sorted by destination planet, so the queries about a
+    // planet don't scan the fleets in flight. A single flat array keeps the map copies cheap.
+    incoming_list incoming_;
+
+    // Travel distances between each pair of planets, row per source planet (shared, as the planets locations
+    // never change during a game)
+    std::shared_ptr<const std::vector<uint16_t>> travel_distances_;
 
     // Data specific for bots
-    player_id   myself_;
-    uint32_t    message_;
-    fleets_list pending_orders_;
+    player_id     myself_;
+    uint32_t      message_;
+    unsigned int  turn_time_;
+    unsigned int  time_bank_;
+    fleets_list   pending_orders_;
+
+    // The pending orders as binary records, for the binary output and the in-process bots
+    std::vector<BinaryOrder> order_records_;
+
+    // The planets as sent by the engine, base of the delta updates (shared, so the map copies stay cheap, and
+    // created by the first input, so the maps constructed by default don't allocate)
+    std::shared_ptr<planets_list> received_planets_;
+
+    protocol_extensions requested_extensions_;
+    protocol_extensions accepted_extensions_;
+    bool                extensions_answer_pending_;
+    bool                binary_protocol_;
+    bool                newline_pending_;     // The end of line following the last text input
+    bool                reset_requested_;
   };
 }
 
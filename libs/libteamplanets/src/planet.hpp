@@ -1,4 +1,4 @@
-// planet.hpp - Planet class definition
+// planet.hpp - Planet, PlanetStore and planet views classes definition
 // libTeamPlanets - A library of common data structures for engine and bots
 //
 // Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
@@ -33,11 +33,21 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstddef>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <vector>
 #include "basic_types.hpp"
 #include "coordinates.hpp"
 
 namespace team_planets {
+  class PlanetStore;
+  class PlanetView;
+  class ConstPlanetView;
+  template<typename StoreT, typename ViewT> class PlanetIterator;
+
+  // A planet on its own, the planets of a map are stored in a PlanetStore and given as views (see below)
   class Planet {
   public:
     Planet():
@@ -47,20 +57,24 @@ namespace team_planets {
       id_(id), location_(location), ship_increase_(ship_increase), current_owner_(current_owner),
       current_num_ships_(current_num_ships) {}
 
+    // Copies of the planets of a store
+    Planet(const ConstPlanetView& planet);
+    Planet(const PlanetView& planet);
+
     // Constant planet data accessors
     planet_id id() const { return id_; }
     const Coordinates& location() const { return location_; }
     unsigned int ship_increase() const { return ship_increase_; }
-    
+
     // Variable planet data accessors
     player_id current_owner() const { return current_owner_; }
     void set_current_owner(player_id new_owner) { current_owner_ = new_owner; }
     unsigned int current_num_ships() const { return current_num_ships_; }
     void set_current_num_ships(unsigned int new_num_ships) { current_num_ships_ = new_num_ships; }
-    
+
     // Various game mechanics functions
     void produce_new_ships() { current_num_ships_ += ship_increase_; }
-    
+
     unsigned int compute_travel_distance(const Planet& other_planet) const {
       return (unsigned int)std::trunc(location_.euclidian_distance(other_planet.location_));
     }
@@ -79,13 +93,225 @@ namespace team_planets {
     planet_id     id_;            // The planet ID
     Coordinates   location_;      // The planet location
     unsigned int  ship_increase_; // Number of ships added per turn
-    
+
     // Variable planet data
     player_id     current_owner_;           // The current owner of the planet
-    unsigned int  current_num_ships_;       // Number of ships currently on this planet         
+    unsigned int  current_num_ships_;       // Number of ships currently on this planet
+  };
+
+  // The planets of a map stored as one array per field, so that the scans over the owners and the ships only walk
+  // over the owners and the ships. The constant data are shared between the copies of a store, only the owners
+  // and the ships are copied. The planets are at the index ID - 1, the holes in the IDs have a null ID.
+  class PlanetStore {
+  public:
+    typedef PlanetIterator<PlanetStore, PlanetView>             iterator;
+    typedef PlanetIterator<const PlanetStore, ConstPlanetView>  const_iterator;
+
+    PlanetStore(): constants_(empty_constants_()) {}
+
+    std::size_t size() const { return owners_.size(); }
+    bool empty() const { return owners_.empty(); }
+    void clear();
+
+    // Replaces the planets by the ones of the range (planets or views), each one placed at the index ID - 1
+    template<typename ForwardIt> void assign(ForwardIt first, ForwardIt last);
+
+    // Planets views, a const store only gives read-only views
+    PlanetView operator[](std::size_t index);
+    ConstPlanetView operator[](std::size_t index) const;
+    iterator begin();
+    const_iterator begin() const;
+    iterator end();
+    const_iterator end() const;
+
+    // Constant data arrays
+    const std::vector<planet_id>& ids() const { return constants_->ids; }
+    const std::vector<Coordinates>& locations() const { return constants_->locations; }
+    const std::vector<unsigned int>& ship_increases() const { return constants_->ship_increases; }
+
+    // Variable data arrays
+    std::vector<player_id>& owners() { return owners_; }
+    const std::vector<player_id>& owners() const { return owners_; }
+    std::vector<unsigned int>& num_ships() { return num_ships_; }
+    const std::vector<unsigned int>& num_ships() const { return num_ships_; }
+
+  private:
+    struct Constants_ {
+      std::vector<planet_id>    ids;
+      std::vector<Coordinates>  locations;
+      std::vector<unsigned int> ship_increases;
+    };
+
+    // The empty stores share the same constant data, so that they don't allocate
+    static const std::shared_ptr<const Constants_>& empty_constants_() {
+      static const std::shared_ptr<const Constants_> empty_constants = std::make_shared<Constants_>();
+      return empty_constants;
+    }
+
+    // The constant data may be shared with copies of the store on other threads, so they are never changed: the
+    // store gets new ones when its planets are replaced (on load only)
+    std::shared_ptr<const Constants_> constants_;
+    std::vector<player_id>            owners_;
+    std::vector<unsigned int>         num_ships_;
+  };
+
+  // A read-only view of a planet of a store with the planet accessors, it stays valid as long as the store exists
+  class ConstPlanetView {
+  public:
+    ConstPlanetView(const PlanetStore& store, std::size_t index):
+      store_(&store), index_(index) {}
+
+    // Constant planet data accessors
+    planet_id id() const { return store_->ids()[index_]; }
+    const Coordinates& location() const { return store_->locations()[index_]; }
+    unsigned int ship_increase() const { return store_->ship_increases()[index_]; }
+
+    // Variable planet data accessors
+    player_id current_owner() const { return store_->owners()[index_]; }
+    unsigned int current_num_ships() const { return store_->num_ships()[index_]; }
+
+    unsigned int compute_travel_distance(const ConstPlanetView& other_planet) const {
+      return (unsigned int)std::trunc(location().euclidian_distance(other_planet.location()));
+    }
+
+  private:
+    const PlanetStore*  store_;
+    std::size_t         index_;
+  };
+
+  // A view of a planet of a store changing the store, it stays valid as long as the store exists
+  class PlanetView {
+  public:
+    PlanetView(PlanetStore& store, std::size_t index):
+      store_(&store), index_(index) {}
+
+    operator ConstPlanetView() const { return ConstPlanetView(*store_, index_); }
+
+    // Constant planet data accessors
+    planet_id id() const { return store_->ids()[index_]; }
+    const Coordinates& location() const { return store_->locations()[index_]; }
+    unsigned int ship_increase() const { return store_->ship_increases()[index_]; }
+
+    // Variable planet data accessors
+    player_id current_owner() const { return store_->owners()[index_]; }
+    void set_current_owner(player_id new_owner) { store_->owners()[index_] = new_owner; }
+    unsigned int current_num_ships() const { return store_->num_ships()[index_]; }
+    void set_current_num_ships(unsigned int new_num_ships) { store_->num_ships()[index_] = new_num_ships; }
+
+    // Various game mechanics functions
+    void produce_new_ships() { store_->num_ships()[index_] += ship_increase(); }
+
+    unsigned int compute_travel_distance(const ConstPlanetView& other_planet) const {
+      return (unsigned int)std::trunc(location().euclidian_distance(other_planet.location()));
+    }
+    void remove_ships(unsigned int num_ships) {
+      assert(num_ships <= current_num_ships());
+      store_->num_ships()[index_] -= num_ships;
+    }
+
+  private:
+    PlanetStore*  store_;
+    std::size_t   index_;
   };
 
-  // Input/output operators
+  // Iterator over the planets of a store, the planets are given as views by value (like the bits of a
+  // std::vector<bool>), the arrow operator points to a copy of the view
+  template<typename StoreT, typename ViewT>
+  class PlanetIterator {
+  public:
+    class ViewPointer {
+    public:
+      explicit ViewPointer(const ViewT& view): view_(view) {}
+      ViewT* operator->() { return &view_; }
+
+    private:
+      ViewT view_;
+    };
+
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef Planet                          value_type;
+    typedef std::ptrdiff_t                  difference_type;
+    typedef ViewPointer                     pointer;
+    typedef ViewT                           reference;
+
+    PlanetIterator(StoreT& store, std::size_t index):
+      store_(&store), index_(index) {}
+
+    reference operator*() const { return ViewT(*store_, index_); }
+    pointer operator->() const { return ViewPointer(**this); }
+    reference operator[](difference_type n) const { return ViewT(*store_, index_ + n); }
+
+    PlanetIterator& operator++() { ++index_; return *this; }
+    PlanetIterator operator++(int) { PlanetIterator it = *this; ++index_; return it; }
+    PlanetIterator& operator--() { --index_; return *this; }
+    PlanetIterator operator--(int) { PlanetIterator it = *this; --index_; return it; }
+    PlanetIterator& operator+=(difference_type n) { index_ += n; return *this; }
+    PlanetIterator& operator-=(difference_type n) { index_ -= n; return *this; }
+    PlanetIterator operator+(difference_type n) const { PlanetIterator it = *this; return it += n; }
+    PlanetIterator operator-(difference_type n) const { PlanetIterator it = *this; return it -= n; }
+    difference_type operator-(const PlanetIterator& it) const {
+      return (difference_type)index_ - (difference_type)it.index_;
+    }
+
+    bool operator==(const PlanetIterator& it) const { return index_ == it.index_; }
+    bool operator!=(const PlanetIterator& it) const { return index_ != it.index_; }
+    bool operator<(const PlanetIterator& it) const { return index_ < it.index_; }
+    bool operator>(const PlanetIterator& it) const { return index_ > it.index_; }
+    bool operator<=(const PlanetIterator& it) const { return index_ <= it.index_; }
+    bool operator>=(const PlanetIterator& it) const { return index_ >= it.index_; }
+
+  private:
+    StoreT*     store_;
+    std::size_t index_;
+  };
+
+  inline Planet::Planet(const ConstPlanetView& planet):
+    id_(planet.id()), location_(planet.location()), ship_increase_(planet.ship_increase()),
+    current_owner_(planet.current_owner()), current_num_ships_(planet.current_num_ships()) {}
+  inline Planet::Planet(const PlanetView& planet):
+    Planet(ConstPlanetView(planet)) {}
+
+  inline PlanetView PlanetStore::operator[](std::size_t index) { return PlanetView(*this, index); }
+  inline ConstPlanetView PlanetStore::operator[](std::size_t index) const { return ConstPlanetView(*this, index); }
+  inline PlanetStore::iterator PlanetStore::begin() { return iterator(*this, 0); }
+  inline PlanetStore::const_iterator PlanetStore::begin() const { return const_iterator(*this, 0); }
+  inline PlanetStore::iterator PlanetStore::end() { return iterator(*this, size()); }
+  inline PlanetStore::const_iterator PlanetStore::end() const { return const_iterator(*this, size()); }
+
+  inline void PlanetStore::clear() {
+    constants_ = empty_constants_();
+    owners_.clear();
+    num_ships_.clear();
+  }
+
+  template<typename ForwardIt> void PlanetStore::assign(ForwardIt first, ForwardIt last) {
+    // Placing planets at correct positions (even if there is holes in planet's IDs)
+    planet_id max_id = 0;
+    for(ForwardIt it = first; it != last; ++it) {
+      if(it->id() > max_id) max_id = it->id();
+    }
+
+    std::shared_ptr<Constants_> constants = std::make_shared<Constants_>();
+    constants->ids.assign(max_id, 0);
+    constants->locations.assign(max_id, Coordinates());
+    constants->ship_increases.assign(max_id, 0);
+    owners_.assign(max_id, neutral_player);
+    num_ships_.assign(max_id, 0);
+
+    for(; first != last; ++first) {
+      assert(first->id() != 0);
+      const std::size_t index = first->id() - 1;
+      constants->ids[index] = first->id();
+      constants->locations[index] = first->location();
+      constants->ship_increases[index] = first->ship_increase();
+      owners_[index] = first->current_owner();
+      num_ships_[index] = first->current_num_ships();
+    }
+
+    constants_ = constants;
+  }
+
+  // Input/output operators, the views are written as planets
   template<typename charT, typename traits>
   std::basic_ostream<charT,traits>& operator<<(std::basic_ostream<charT,traits>& out, const Planet& P) {
     out << "P " << P.id_ << ' ' << P.location_ << ' ';
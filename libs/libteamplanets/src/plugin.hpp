@@ -0,0 +1,74 @@
+// plugin.hpp - In-process bots interface
+// libTeamPlanets - A library of common data structures for engine and bots
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#ifndef _TEAMPLANETS_LIBTEAMPLANETS_PLUGIN_HPP_
+#define _TEAMPLANETS_LIBTEAMPLANETS_PLUGIN_HPP_
+
+#include <cstdint>
+#include "protocol.hpp"
+
+// A bot may also be built as a shared object (with the .so extension) loaded by the engine in its own
+// process. The engine then calls the entry points below directly, without any process, pipe or protocol
+// parsing: the input and output of each turn are the records of the binary protocol, passed in memory. The
+// plugin instances are called by the battle threads, several of them may be used at the same time by
+// different threads, so the bots must not share any global state. No exception may leave the entry points.
+extern "C" {
+  // Input of a turn, the planets are full records of all the planets
+  struct teamplanets_turn_input {
+    uint32_t                          myself;
+    uint32_t                          message;
+    uint32_t                          turn_time;    // Time control in ms, both null without time bank
+    uint32_t                          time_bank;
+    uint32_t                          num_planets;
+    const team_planets::BinaryPlanet* planets;
+  };
+
+  // Output of a turn, the orders are owned by the bot and stay valid until its next call
+  struct teamplanets_turn_output {
+    uint32_t                          message;
+    uint32_t                          num_orders;
+    const team_planets::BinaryOrder*  orders;
+  };
+
+  // New bot instance, null on failure
+  void* teamplanets_bot_init();
+  // Plays a turn, returns 0 on success
+  int teamplanets_bot_turn(void* bot, const teamplanets_turn_input* input, teamplanets_turn_output* output);
+  // Forgets the game, the next turn is the first one of a new game, returns 0 on success
+  int teamplanets_bot_reset(void* bot);
+  void teamplanets_bot_free(void* bot);
+
+  typedef void* (*teamplanets_bot_init_function)();
+  typedef int (*teamplanets_bot_turn_function)(void*, const teamplanets_turn_input*, teamplanets_turn_output*);
+  typedef int (*teamplanets_bot_reset_function)(void*);
+  typedef void (*teamplanets_bot_free_function)(void*);
+}
+
+#endif
@@ -0,0 +1,112 @@
+// protocol.hpp - Engine/bot protocol extensions
+// libTeamPlanets - A library of common data structures for engine and bots
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#ifndef _TEAMPLANETS_LIBTEAMPLANETS_PROTOCOL_HPP_
+#define _TEAMPLANETS_LIBTEAMPLANETS_PROTOCOL_HPP_
+
+#include <cstdint>
+
+namespace team_planets {
+  // Protocol extensions flags, offered by the engine on the first turn and accepted by the bot in its first
+  // output, both with the X tag
+  typedef uint32_t protocol_extensions;
+
+  const protocol_extensions no_extensions       = 0;
+  const protocol_extensions delta_extension     = 1;  // After the first turn only the changed planets are sent
+  const protocol_extensions binary_extension    = 2;  // After the first turn the binary frames below are used
+  const protocol_extensions reset_extension     = 4;  // The bot process may be reset to play another game
+  const protocol_extensions time_bank_extension = 8;  // After the first turn the time control is sent
+
+  // Time control: when the engine plays with a time bank, the input contains a T tag followed by the time
+  // allowed for each turn and the remaining time bank, in ms. A bot may answer later than the turn time, the
+  // excess is taken from its bank, and the unused turn time goes back to the bank (up to its initial size).
+  // The T tag is sent on the first turn (the bots unaware of it ignore it), then only if the bot accepts the
+  // extension.
+
+  // Reset handshake: at the end of a game the engine sends an R tag (or a binary frame with the reset flag)
+  // instead of the planets. The bot forgets the game, goes back to the text protocol and answers with an
+  // empty text output. The next input is the first turn of a new game.
+
+  // Binary protocol frames, fixed width records in the native byte order. The engine input frame is a header
+  // followed by the planet records (full or delta ones), the bot output frame is a header followed by the
+  // order records. The frame size includes the header.
+  const uint32_t binary_full_planets = 1; // Input frame flag, set when the records are BinaryPlanet
+  const uint32_t binary_reset        = 2; // Input frame flag, reset request without any record
+  const uint32_t binary_time_bank    = 4; // Input frame flag, set when a BinaryTimeBank follows the header
+
+  struct BinaryInputHeader {
+    uint32_t  size;
+    uint32_t  flags;
+    uint32_t  myself;
+    uint32_t  message;
+    uint32_t  num_planets;
+  };
+
+  struct BinaryTimeBank {
+    uint32_t  turn_time;
+    uint32_t  time_bank;
+  };
+
+  struct BinaryPlanet {
+    uint32_t  id;
+    float     x;
+    float     y;
+    uint32_t  ship_increase;
+    uint32_t  owner;
+    uint32_t  num_ships;
+  };
+
+  struct BinaryPlanetDelta {
+    uint32_t  id;
+    uint32_t  owner;
+    uint32_t  num_ships;
+  };
+
+  struct BinaryOutputHeader {
+    uint32_t  size;
+    uint32_t  message;
+    uint32_t  num_orders;
+  };
+
+  struct BinaryOrder {
+    uint32_t  source;
+    uint32_t  destination;
+    uint32_t  num_ships;
+  };
+
+  static_assert(sizeof(BinaryInputHeader) == 20, "Unexpected binary protocol frame layout.");
+  static_assert(sizeof(BinaryTimeBank) == 8, "Unexpected binary protocol frame layout.");
+  static_assert(sizeof(BinaryPlanet) == 24, "Unexpected binary protocol frame layout.");
+  static_assert(sizeof(BinaryPlanetDelta) == 12, "Unexpected binary protocol frame layout.");
+  static_assert(sizeof(BinaryOutputHeader) == 12, "Unexpected binary protocol frame layout.");
+  static_assert(sizeof(BinaryOrder) == 12, "Unexpected binary protocol frame layout.");
+}
+
+#endif
@@ -0,0 +1,115 @@
+// incoming_ships_check.cpp - Randomized check of the incoming ships index
+// libTeamPlanets - A library of common data structures for engine and bots
+//
+// Copyright (c) 2015 Vadim Litvinov <vadim_litvinov@fastmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the author nor the names of its contributors
+//    may be used to endorse or promote products derived from this software
+//    without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <algorithm>
+#include "map.hpp"
+
+using namespace std;
+using namespace team_planets;
+
+const player_id num_players = 4;
+const unsigned int num_turns = 300;
+const unsigned int launches_per_turn = 20;
+
+// Compares the index queries with a scan of the fleets in flight, returns false on the first mismatch
+static bool check_incoming_ships(const Map& map, unsigned int turn) {
+  const unsigned int horizons[] = {0, 1, 3, 10, numeric_limits<unsigned int>::max()};
+
+  for(planet_id id = 1; id <= map.num_planets(); ++id) {
+    const bool targeted = any_of(map.fleets_begin(), map.fleets_end(), [id](const Fleet& fleet) {
+      return fleet.destination() == id;
+    });
+    if(targeted != map.bot_planet_is_targeted_by_a_fleet(id)) {
+      cerr << "Turn " << turn << ", planet " << id << ": targeting mismatch." << endl;
+      return false;
+    }
+
+    for(player_id player = neutral_player; player <= num_players; ++player) {
+      for(unsigned int horizon:horizons) {
+        unsigned int expected = 0;
+        for_each(map.fleets_begin(), map.fleets_end(), [&](const Fleet& fleet) {
+          if(fleet.destination() == id && fleet.player() == player && fleet.remaining_turns() <= horizon)
+            expected += fleet.num_ships();
+        });
+
+        const unsigned int indexed = map.incoming_ships(id, player, horizon);
+        if(indexed != expected) {
+          cerr << "Turn " << turn << ", planet " << id << ", player " << player << ", horizon " << horizon
+               << ": " << indexed << " ships indexed instead of " << expected << "." << endl;
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, char** argv) {
+  if(argc != 2) {
+    cerr << "Usage: " << argv[0] << " <map file>" << endl;
+    return 1;
+  }
+
+  // Giving every planet to a player so all of them can launch fleets
+  Map map;
+  map.load(argv[1]);
+  for(planet_id id = 1; id <= map.num_planets(); ++id) {
+    map.planet(id).set_current_owner(1 + id%num_players);
+    map.planet(id).set_current_num_ships(1000);
+  }
+
+  srand(42);
+  for(unsigned int turn = 0; turn < num_turns; ++turn) {
+    // Random launches, zero ship fleets and fleets sent to their own source planet included
+    for(unsigned int i = 0; i < launches_per_turn; ++i) {
+      const planet_id source = 1 + rand()%map.num_planets();
+      const planet_id destination = (i%10 == 0) ? source : 1 + rand()%map.num_planets();
+      const player_id player = map.planet(source).current_owner();
+      if(player == neutral_player) continue;
+
+      const unsigned int num_ships = rand()%(map.planet(source).current_num_ships()/2 + 1);
+      map.engine_launch_fleet(player, source, destination, num_ships);
+    }
+
+    if(turn%50 == 49) map.engine_eliminate_player_fleets(1 + (turn/50)%num_players);
+    map.engine_perform_turn();
+
+    // The bots work on copies of the map, the copies must answer the same
+    const Map copy(map);
+    if(!check_incoming_ships(map, turn) || !check_incoming_ships(copy, turn)) return 1;
+  }
+
+  cout << "Incoming ships index matches the fleets after " << num_turns << " turns." << endl;
+  return 0;
+}